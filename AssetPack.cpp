@@ -0,0 +1,129 @@
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool AssetPack::open(const char* path) {
+    close();
+#ifdef _WIN32
+    HANDLE f = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open " << path << "\n";
+        return false;
+    }
+    LARGE_INTEGER len;
+    GetFileSizeEx(f, &len);
+    HANDLE m = len.QuadPart ? CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    void* view = m ? MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!view) {
+        if (m) CloseHandle(m);
+        CloseHandle(f);
+        std::cerr << "Failed to map " << path << "\n";
+        return false;
+    }
+    file = f;
+    mapping = m;
+    size = (size_t)len.QuadPart;
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Failed to open " << path << "\n";
+        return false;
+    }
+    struct stat st;
+    void* view = fstat(fd, &st) == 0 && st.st_size > 0
+        ? mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    ::close(fd);   // the mapping keeps the file alive
+    if (view == MAP_FAILED) {
+        std::cerr << "Failed to map " << path << "\n";
+        return false;
+    }
+    size = (size_t)st.st_size;
+#endif
+    base = (const uint8_t*)view;
+
+    if (!validate()) {
+        std::cerr << path << " is not a valid asset pack (version " << PACK_VERSION << ")\n";
+        close();
+        return false;
+    }
+    const PackHeader& h = header();
+    mips = (const PackMip*)(base + sizeof(PackHeader));
+    sprites = (const PackSprite*)(mips + h.MipCount);
+    sounds = (const PackSound*)(sprites + h.SpriteCount);
+    return true;
+}
+
+void AssetPack::close() {
+    if (!base) return;
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+    CloseHandle((HANDLE)mapping);
+    CloseHandle((HANDLE)file);
+    file = mapping = nullptr;
+#else
+    munmap((void*)base, size);
+#endif
+    base = nullptr;
+    size = 0;
+    mips = nullptr;
+    sprites = nullptr;
+    sounds = nullptr;
+}
+
+bool AssetPack::validate() const {
+    if (size < sizeof(PackHeader)) return false;
+    const PackHeader& h = header();
+    if (memcmp(h.Magic, "ZVPK", 4) != 0 || h.Version != PACK_VERSION) return false;
+    // an atlas has at least its full-size level and at most down to 1x1
+    if (h.AtlasWidth == 0 || h.AtlasHeight == 0 || h.MipCount == 0 || h.MipCount > 32) return false;
+
+    uint64_t tables = sizeof(PackHeader) + (uint64_t)h.MipCount * sizeof(PackMip)
+        + (uint64_t)h.SpriteCount * sizeof(PackSprite) + (uint64_t)h.SoundCount * sizeof(PackSound);
+    if (tables > size) return false;
+    // `count` items of `itemBytes` each, divided rather than multiplied so
+    // that no size in the file can wrap around
+    auto inside = [&](uint64_t offset, uint64_t count, uint64_t itemBytes) {
+        return offset >= tables && offset <= size && count <= (size - offset) / itemBytes;
+    };
+
+    const PackMip* m = (const PackMip*)(base + sizeof(PackHeader));
+    for (uint32_t l = 0; l < h.MipCount; ++l) {
+        // the size glTexImage2D is told is the size the level must be
+        if (m[l].Width != std::max(h.AtlasWidth >> l, 1u) || m[l].Height != std::max(h.AtlasHeight >> l, 1u))
+            return false;
+        if (!inside(m[l].Offset, (uint64_t)m[l].Width * m[l].Height, 4)) return false;
+    }
+    const PackSound* s = (const PackSound*)(base + tables - (uint64_t)h.SoundCount * sizeof(PackSound));
+    for (uint32_t i = 0; i < h.SoundCount; ++i) {
+        if (s[i].Channels == 0 || s[i].SampleRate == 0) return false;
+        if (s[i].Frames > UINT64_MAX / s[i].Channels ||
+            !inside(s[i].Offset, s[i].Frames * s[i].Channels, sizeof(float)))
+            return false;
+    }
+    return true;
+}
+
+const PackSprite* AssetPack::findSprite(const char* name) const {
+    for (uint32_t i = 0; i < header().SpriteCount; ++i)
+        if (strncmp(sprites[i].Name, name, sizeof(sprites[i].Name)) == 0) return &sprites[i];
+    return nullptr;
+}
+
+const PackSound* AssetPack::findSound(const char* name) const {
+    for (uint32_t i = 0; i < header().SoundCount; ++i)
+        if (strncmp(sounds[i].Name, name, sizeof(sounds[i].Name)) == 0) return &sounds[i];
+    return nullptr;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Asset archive written by tools/AssetPacker.cpp and memory-mapped by the
+// game. Everything is already in the form the GPU and the audio device
+// take it, so loading is a map plus one upload per mip level.
+//
+// Layout, little-endian, every offset from the start of the file and
+// every blob 16-byte aligned:
+//   PackHeader
+//   PackMip[MipCount]        atlas levels, RGBA8, rows bottom-up (GL order)
+//   PackSprite[SpriteCount]  named UV rects in the atlas
+//   PackSound[SoundCount]    named f32 interleaved PCM
+//   blobs
+const uint32_t PACK_VERSION = 1;
+
+struct PackHeader {
+    char     Magic[4];   // "ZVPK"
+    uint32_t Version;
+    uint32_t AtlasWidth, AtlasHeight;
+    uint32_t MipCount, SpriteCount, SoundCount;
+    uint32_t Reserved;
+};
+
+struct PackMip {
+    uint32_t Width, Height;
+    uint64_t Offset;
+};
+
+struct PackSprite {
+    char     Name[32];
+    float    U0, V0, U1, V1;    // texture coordinates of the sprite's corners
+    uint32_t Width, Height;     // source size in pixels
+    uint32_t Reserved[2];
+};
+
+struct PackSound {
+    char     Name[32];
+    uint32_t Channels, SampleRate;
+    uint64_t Frames;
+    uint64_t Offset;
+    uint64_t Reserved;
+};
+
+static_assert(sizeof(PackHeader) == 32 && sizeof(PackMip) == 16 &&
+    sizeof(PackSprite) == 64 && sizeof(PackSound) == 64, "pack structs are written as-is");
+
+// Read-only view of a mapped pack. Pointers it hands out stay valid until
+// close(), so the pack must outlive anything that plays or uploads from it.
+class AssetPack {
+public:
+    AssetPack() = default;
+    ~AssetPack() { close(); }
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    // maps the file and checks that every table and blob lies inside it
+    bool open(const char* path);
+    void close();
+    bool isOpen() const { return base != nullptr; }
+
+    const PackHeader& header() const { return *(const PackHeader*)base; }
+    const PackMip& mip(uint32_t level) const { return mips[level]; }
+    const void* data(uint64_t offset) const { return base + offset; }
+
+    // nullptr when the pack has no entry of that name
+    const PackSprite* findSprite(const char* name) const;
+    const PackSound* findSound(const char* name) const;
+
+private:
+    bool validate() const;
+
+    const uint8_t*    base = nullptr;
+    size_t            size = 0;
+    const PackMip*    mips = nullptr;
+    const PackSprite* sprites = nullptr;
+    const PackSound*  sounds = nullptr;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
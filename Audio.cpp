@@ -0,0 +1,184 @@
+#include "Audio.h"
+
+#include <chrono>
+#include <iostream>
+
+static const ma_uint32 CHANNELS = 2;
+
+bool AudioSystem::init(unsigned int sampleRate, unsigned int periodFrames) {
+    // the engine mixes into whatever buffer we hand it, from our callback
+    ma_engine_config engineConfig = ma_engine_config_init();
+    engineConfig.noDevice = MA_TRUE;
+    engineConfig.channels = CHANNELS;
+    engineConfig.sampleRate = sampleRate;
+    if (ma_engine_init(&engineConfig, &engine) != MA_SUCCESS) {
+        std::cerr << "Failed to initialize audio engine\n";
+        return false;
+    }
+    engineReady = true;
+
+    ma_device_config config = ma_device_config_init(ma_device_type_playback);
+    config.playback.format = ma_format_f32;
+    config.playback.channels = CHANNELS;
+    config.sampleRate = sampleRate;
+    config.periodSizeInFrames = periodFrames;
+    config.dataCallback = dataCallback;
+    config.pUserData = this;
+    if (ma_device_init(NULL, &config, &device) != MA_SUCCESS) {
+        std::cerr << "Failed to open audio device\n";
+        return false;
+    }
+    deviceReady = true;
+
+    if (ma_device_start(&device) != MA_SUCCESS) {
+        std::cerr << "Failed to start audio device\n";
+        return false;
+    }
+    started = true;
+    return true;
+}
+
+void AudioSystem::shutdown() {
+    // device first, so the callback is gone before the voices go
+    if (deviceReady) ma_device_uninit(&device);
+    deviceReady = started = false;
+    for (int i = 0; i < soundCount; ++i) {
+        SoundData& s = sounds[i];
+        for (int v = 0; v < s.VoiceCount; ++v) {
+            ma_sound_uninit(&s.Voices[v].Sound);
+            ma_audio_buffer_uninit(&s.Voices[v].Buffer);
+        }
+        delete[] s.Voices;
+        if (s.OwnsPcm) ma_free(s.Pcm, NULL);
+        s = SoundData();
+    }
+    soundCount = 0;
+    if (engineReady) ma_engine_uninit(&engine);
+    engineReady = false;
+}
+
+SoundId AudioSystem::load(const char* path, int voices) {
+    if (!engineReady || soundCount == MAX_SOUNDS || voices <= 0) return INVALID_SOUND;
+
+    // decode up front, converted to exactly what the engine mixes
+    ma_decoder_config decoderConfig = ma_decoder_config_init(ma_format_f32, CHANNELS, ma_engine_get_sample_rate(&engine));
+    ma_uint64 frames;
+    void* pcm;
+    if (ma_decode_file(path, &decoderConfig, &frames, &pcm) != MA_SUCCESS) {
+        std::cerr << "Failed to decode " << path << "\n";
+        return INVALID_SOUND;
+    }
+    SoundId id = addSound(pcm, frames, true, voices);
+    if (id == INVALID_SOUND) std::cerr << "Failed to create voices for " << path << "\n";
+    return id;
+}
+
+SoundId AudioSystem::loadPcm(const void* pcm, uint64_t frames, unsigned int channels, unsigned int sampleRate, int voices) {
+    if (!engineReady || soundCount == MAX_SOUNDS || voices <= 0) return INVALID_SOUND;
+    // voices play the buffer as-is, there is no conversion on this path
+    if (channels != CHANNELS || sampleRate != ma_engine_get_sample_rate(&engine)) {
+        std::cerr << "Sound is " << channels << " ch " << sampleRate << " Hz, the device runs "
+            << CHANNELS << " ch " << ma_engine_get_sample_rate(&engine) << " Hz\n";
+        return INVALID_SOUND;
+    }
+    return addSound((void*)pcm, frames, false, voices);
+}
+
+SoundId AudioSystem::addSound(void* pcm, uint64_t frames, bool ownsPcm, int voices) {
+    SoundData s;
+    s.Pcm = pcm;
+    s.Frames = frames;
+    s.OwnsPcm = ownsPcm;
+    s.Voices = new Voice[voices];
+    for (int v = 0; v < voices; ++v) {
+        Voice& voice = s.Voices[v];
+        // every voice reads the same PCM through its own cursor
+        ma_audio_buffer_config bufferConfig = ma_audio_buffer_config_init(ma_format_f32, CHANNELS, s.Frames, s.Pcm, NULL);
+        if (ma_audio_buffer_init(&bufferConfig, &voice.Buffer) != MA_SUCCESS) break;
+        if (ma_sound_init_from_data_source(&engine, &voice.Buffer,
+                MA_SOUND_FLAG_NO_SPATIALIZATION | MA_SOUND_FLAG_NO_PITCH, NULL, &voice.Sound) != MA_SUCCESS) {
+            ma_audio_buffer_uninit(&voice.Buffer);
+            break;
+        }
+        s.VoiceCount++;
+    }
+    if (!s.VoiceCount) {
+        delete[] s.Voices;
+        if (ownsPcm) ma_free(pcm, NULL);
+        return INVALID_SOUND;
+    }
+
+    // published to the audio thread by the queue's release on play()
+    sounds[soundCount] = s;
+    return soundCount++;
+}
+
+void AudioSystem::play(SoundId id, float volume) {
+    if (!started || id < 0 || id >= soundCount) return;
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == QUEUE_SIZE) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    queue[h & (QUEUE_SIZE - 1)] = { id, volume };
+    head.store(h + 1, std::memory_order_release);
+}
+
+AudioStats AudioSystem::stats() {
+    AudioStats s;
+    s.Plays = plays.load(std::memory_order_relaxed);
+    s.Steals = steals.load(std::memory_order_relaxed);
+    s.Dropped = dropped.load(std::memory_order_relaxed);
+    s.Callbacks = callbacks.load(std::memory_order_relaxed);
+    s.CallbackUsLast = callbackNsLast.load(std::memory_order_relaxed) / 1000.0;
+    s.CallbackUsPeak = callbackNsPeak.exchange(0, std::memory_order_relaxed) / 1000.0;
+    for (int i = 0; i < soundCount; ++i) {
+        for (int v = 0; v < sounds[i].VoiceCount; ++v)
+            if (ma_sound_is_playing(&sounds[i].Voices[v].Sound)) s.VoicesBusy++;
+        s.Voices += sounds[i].VoiceCount;
+    }
+    return s;
+}
+
+void AudioSystem::dataCallback(ma_device* device, void* out, const void* in, ma_uint32 frames) {
+    AudioSystem* self = (AudioSystem*)device->pUserData;
+    auto start = std::chrono::steady_clock::now();
+
+    self->drainQueue();
+    ma_engine_read_pcm_frames(&self->engine, out, frames, NULL);
+
+    uint32_t ns = (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    self->callbackNsLast.store(ns, std::memory_order_relaxed);
+    if (ns > self->callbackNsPeak.load(std::memory_order_relaxed))
+        self->callbackNsPeak.store(ns, std::memory_order_relaxed);
+    self->callbacks.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AudioSystem::drainQueue() {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    uint32_t h = head.load(std::memory_order_acquire);
+    for (; t != h; ++t) {
+        const PlayRequest& req = queue[t & (QUEUE_SIZE - 1)];
+        startVoice(sounds[req.Sound], req.Volume);
+    }
+    tail.store(t, std::memory_order_release);
+}
+
+// a free voice if there is one, otherwise the one that started first
+void AudioSystem::startVoice(SoundData& s, float volume) {
+    Voice* pick = nullptr;
+    for (int v = 0; v < s.VoiceCount; ++v) {
+        Voice& voice = s.Voices[v];
+        if (!ma_sound_is_playing(&voice.Sound)) { pick = &voice; break; }
+        if (!pick || voice.StartedAt < pick->StartedAt) pick = &voice;
+    }
+    if (ma_sound_is_playing(&pick->Sound))
+        steals.fetch_add(1, std::memory_order_relaxed);
+
+    pick->StartedAt = ++playSeq;
+    ma_sound_set_volume(&pick->Sound, volume);
+    ma_sound_seek_to_pcm_frame(&pick->Sound, 0);
+    ma_sound_start(&pick->Sound);
+    plays.fetch_add(1, std::memory_order_relaxed);
+}
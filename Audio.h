@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "SDL3/miniaudio.h"
+
+typedef int SoundId;
+const SoundId INVALID_SOUND = -1;
+
+// Snapshot of what the audio thread has been doing. Callback times are in
+// microseconds; the peak covers the time since the previous stats() call.
+struct AudioStats {
+    uint64_t Plays = 0;
+    uint64_t Steals = 0;          // plays that cut off the oldest voice of a sound
+    uint64_t Dropped = 0;         // requests lost because the queue was full
+    uint64_t Callbacks = 0;
+    double   CallbackUsLast = 0;
+    double   CallbackUsPeak = 0;
+    unsigned VoicesBusy = 0;
+    unsigned Voices = 0;
+};
+
+// Sound effects on top of ma_engine, driven by our own playback device.
+// Effects are decoded once at load into f32 PCM at the device rate, and
+// every sound owns a fixed set of voices (an ma_sound over its own
+// ma_audio_buffer) created up front, so playing never decodes, allocates
+// or initializes anything. play() only pushes a request onto a
+// single-producer ring; the device callback drains it, starts the voices
+// and then mixes the engine, so the game thread never waits on the device.
+class AudioSystem {
+public:
+    static const int MAX_SOUNDS = 16;
+    static const int QUEUE_SIZE = 64;     // power of two
+
+    AudioSystem() = default;
+    ~AudioSystem() { shutdown(); }
+    AudioSystem(const AudioSystem&) = delete;
+    AudioSystem& operator=(const AudioSystem&) = delete;
+
+    // opens the device; `periodFrames` is the callback size (latency)
+    bool init(unsigned int sampleRate = 48000, unsigned int periodFrames = 256);
+    void shutdown();
+    bool ready() const { return started; }
+
+    // decode a whole file into memory and give it `voices` simultaneous voices
+    SoundId load(const char* path, int voices = 8);
+    // the same for PCM that is already decoded (f32, stereo, device rate),
+    // e.g. from an asset pack; `pcm` is not copied and must outlive us
+    SoundId loadPcm(const void* pcm, uint64_t frames, unsigned int channels, unsigned int sampleRate, int voices = 8);
+
+    // game thread only; never blocks
+    void play(SoundId id, float volume = 1.f);
+
+    AudioStats stats();
+
+private:
+    struct Voice {
+        ma_audio_buffer Buffer;
+        ma_sound        Sound;
+        uint64_t        StartedAt = 0;   // play sequence number, for stealing
+    };
+    struct SoundData {
+        void*    Pcm = nullptr;
+        uint64_t Frames = 0;
+        bool     OwnsPcm = false;
+        Voice*   Voices = nullptr;
+        int      VoiceCount = 0;
+    };
+    struct PlayRequest {
+        SoundId Sound;
+        float   Volume;
+    };
+
+    static void dataCallback(ma_device* device, void* out, const void* in, ma_uint32 frames);
+    SoundId addSound(void* pcm, uint64_t frames, bool ownsPcm, int voices);
+    void drainQueue();
+    void startVoice(SoundData& s, float volume);
+
+    ma_device device;
+    ma_engine engine;
+    bool deviceReady = false;
+    bool engineReady = false;
+    bool started = false;
+
+    SoundData sounds[MAX_SOUNDS];
+    int soundCount = 0;
+
+    // single producer (game) / single consumer (audio callback)
+    PlayRequest queue[QUEUE_SIZE];
+    std::atomic<uint32_t> head{ 0 };   // written by the game thread
+    std::atomic<uint32_t> tail{ 0 };   // written by the audio thread
+
+    // audio thread only
+    uint64_t playSeq = 0;
+
+    std::atomic<uint64_t> plays{ 0 };
+    std::atomic<uint64_t> steals{ 0 };
+    std::atomic<uint64_t> dropped{ 0 };
+    std::atomic<uint64_t> callbacks{ 0 };
+    std::atomic<uint32_t> callbackNsLast{ 0 };
+    std::atomic<uint32_t> callbackNsPeak{ 0 };
+};
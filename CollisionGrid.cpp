@@ -0,0 +1,89 @@
+#include "CollisionGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+CollisionGrid::CollisionGrid(float worldWidth, float worldHeight, float cellSize)
+    : originX(-cellSize), originY(-cellSize), invCellSize(1.f / cellSize) {
+    cols = (int)std::ceil(worldWidth / cellSize) + 2;
+    rows = (int)std::ceil(worldHeight / cellSize) + 2;
+    cellStart.resize((size_t)cols * rows + 1);
+}
+
+void CollisionGrid::reserve(size_t n) {
+    pointCell.reserve(n);
+    cellItems.reserve(n);
+    claimed.reserve(n);
+}
+
+int CollisionGrid::cellX(float x) const {
+    int c = (int)std::floor((x - originX) * invCellSize);
+    return std::min(std::max(c, 0), cols - 1);
+}
+
+int CollisionGrid::cellY(float y) const {
+    int c = (int)std::floor((y - originY) * invCellSize);
+    return std::min(std::max(c, 0), rows - 1);
+}
+
+void CollisionGrid::build(const glm::vec2* pts, size_t count, size_t byteStride) {
+    points = pts;
+    stride = byteStride;
+    pointCell.resize(count);
+    cellItems.resize(count);
+    claimed.assign(count, 0);
+    std::fill(cellStart.begin(), cellStart.end(), 0u);
+
+    // counting sort by cell: count, prefix-sum, scatter. Scattering in index
+    // order keeps every cell's list ascending, which claim() relies on.
+    for (uint32_t i = 0; i < count; ++i) {
+        const glm::vec2& p = point(i);
+        uint32_t c = (uint32_t)(cellY(p.y) * cols + cellX(p.x));
+        pointCell[i] = c;
+        cellStart[c + 1]++;
+    }
+    for (size_t c = 1; c < cellStart.size(); ++c)
+        cellStart[c] += cellStart[c - 1];
+    for (uint32_t i = 0; i < count; ++i)
+        cellItems[cellStart[pointCell[i]]++] = i;
+    // the scatter advanced each start to the next cell's start; shift back
+    for (size_t c = cellStart.size() - 1; c > 0; --c)
+        cellStart[c] = cellStart[c - 1];
+    cellStart[0] = 0;
+}
+
+uint32_t CollisionGrid::find(glm::vec2 pos, glm::vec2 size, bool skipClaimed) const {
+    int x0 = cellX(pos.x), x1 = cellX(pos.x + size.x);
+    int y0 = cellY(pos.y), y1 = cellY(pos.y + size.y);
+
+    uint32_t best = UINT32_MAX;
+    for (int cy = y0; cy <= y1; ++cy) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            uint32_t c = (uint32_t)(cy * cols + cx);
+            for (uint32_t k = cellStart[c]; k < cellStart[c + 1]; ++k) {
+                uint32_t i = cellItems[k];
+                if (i >= best) break;   // lists are ascending, nothing lower follows
+                if (skipClaimed && claimed[i]) continue;
+                const glm::vec2& b = point(i);
+                if (b.x > pos.x && b.x < pos.x + size.x &&
+                    b.y > pos.y && b.y < pos.y + size.y) {
+                    best = i;
+                    break;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+int CollisionGrid::claim(glm::vec2 pos, glm::vec2 size) {
+    uint32_t best = find(pos, size, true);
+    if (best == UINT32_MAX) return -1;
+    claimed[best] = 1;
+    return (int)best;
+}
+
+int CollisionGrid::firstInside(glm::vec2 pos, glm::vec2 size) const {
+    uint32_t best = find(pos, size, false);
+    return best == UINT32_MAX ? -1 : (int)best;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Uniform-grid broad phase for the bullet-vs-enemy test. Bullets are
+// bucketed as points once per tick; each enemy box then only looks at the
+// cells it overlaps instead of at every bullet.
+class CollisionGrid {
+public:
+    // the grid covers the world plus one cell of margin on every side;
+    // anything further out is clamped into the border cells
+    CollisionGrid(float worldWidth, float worldHeight, float cellSize);
+
+    // size the per-point arrays up front so build() does not allocate
+    void reserve(size_t points);
+
+    // bucket `count` points read from `points` every `stride` bytes
+    // (so an array of structs can be passed without copying positions out)
+    void build(const glm::vec2* points, size_t count, size_t stride = sizeof(glm::vec2));
+
+    // lowest-index point that is not claimed yet and lies strictly inside
+    // the box, exactly like the AABB test in the game loop; the point is
+    // marked claimed. Returns -1 when nothing hits.
+    int claim(glm::vec2 pos, glm::vec2 size);
+
+    // the same query without claiming, and ignoring earlier claims; safe to
+    // run from several threads at once between build() and the first claim
+    int firstInside(glm::vec2 pos, glm::vec2 size) const;
+    // claim point `i` if nobody has; true when this call claimed it
+    bool tryClaim(size_t i) {
+        if (claimed[i]) return false;
+        claimed[i] = 1;
+        return true;
+    }
+
+    bool isClaimed(size_t i) const { return claimed[i] != 0; }
+    size_t pointCount() const { return claimed.size(); }
+    int columns() const { return cols; }
+    int rowCount() const { return rows; }
+
+private:
+    int cellX(float x) const;
+    int cellY(float y) const;
+    uint32_t find(glm::vec2 pos, glm::vec2 size, bool skipClaimed) const;
+    const glm::vec2& point(uint32_t i) const {
+        return *(const glm::vec2*)((const char*)points + i * stride);
+    }
+
+    float originX, originY, invCellSize;
+    int cols, rows;
+
+    const glm::vec2* points = nullptr;
+    size_t stride = sizeof(glm::vec2);
+    std::vector<uint32_t> cellStart;   // prefix sums, cols * rows + 1 entries
+    std::vector<uint32_t> cellItems;   // point indices grouped by cell, ascending in each cell
+    std::vector<uint32_t> pointCell;
+    std::vector<uint8_t>  claimed;
+};
@@ -0,0 +1,81 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+
+// weight of the newest frame in the smoothed GPU time
+static const double GPU_MS_SMOOTHING = 0.1;
+// scale back up only below this fraction of the budget, so the scale does
+// not flip between two steps that sit either side of it
+static const double HEADROOM = 0.8;
+
+void DynamicResolution::init(const DynamicResolutionConfig& cfg, bool adapt, float startScale) {
+    destroy();
+    config = cfg;
+    adaptive = adapt;
+    current = std::min(std::max(startScale, config.MinScale), config.MaxScale);
+    smoothedMs = 0;
+    hold = config.HoldFrames;
+    for (Frame& f : frames) {
+        glGenQueries(1, &f.Start);
+        glGenQueries(1, &f.End);
+        f.Issued = false;
+    }
+    frame = 0;
+    ready = true;
+}
+
+void DynamicResolution::destroy() {
+    if (!ready) return;
+    for (Frame& f : frames) {
+        glDeleteQueries(1, &f.Start);
+        glDeleteQueries(1, &f.End);
+        f = Frame();
+    }
+    ready = false;
+}
+
+void DynamicResolution::beginFrame() {
+    if (!ready) return;
+    frame = (frame + 1) % QUERY_FRAMES;
+    Frame& f = frames[frame];
+    if (f.Issued) {
+        GLint available = 0;
+        glGetQueryObjectiv(f.End, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint64 start = 0, end = 0;
+            glGetQueryObjectui64v(f.Start, GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(f.End, GL_QUERY_RESULT, &end);
+            double ms = (end - start) / 1e6;
+            smoothedMs = smoothedMs > 0 ? smoothedMs + (ms - smoothedMs) * GPU_MS_SMOOTHING : ms;
+        }
+        f.Issued = false;
+    }
+
+    if (adaptive && smoothedMs > 0 && --hold <= 0) {
+        float next = current;
+        if (smoothedMs > config.BudgetMs) next = current - config.Step;
+        else if (smoothedMs < config.BudgetMs * HEADROOM) next = current + config.Step;
+        next = std::min(std::max(next, config.MinScale), config.MaxScale);
+        if (next != current) {
+            current = next;
+            hold = config.HoldFrames;
+        }
+        else hold = 0;
+    }
+
+    glQueryCounter(f.Start, GL_TIMESTAMP);
+}
+
+void DynamicResolution::endFrame() {
+    if (!ready) return;
+    Frame& f = frames[frame];
+    glQueryCounter(f.End, GL_TIMESTAMP);
+    f.Issued = true;
+}
+
+void DynamicResolution::drawSize(int outW, int outH, int& w, int& h) const {
+    w = std::max(8, ((int)(outW * current) + 7) & ~7);
+    h = std::max(8, ((int)(outH * current) + 7) & ~7);
+    w = std::min(w, outW);
+    h = std::min(h, outH);
+}
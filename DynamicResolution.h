@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glad/glad.h>
+
+struct DynamicResolutionConfig {
+    float BudgetMs = 14.f;     // GPU time per frame to stay under
+    float MinScale = 0.5f;     // per axis, of the output resolution
+    float MaxScale = 1.f;
+    float Step = 0.05f;
+    int   HoldFrames = 30;     // between changes, so one shows up in the timings before the next
+};
+
+// Chooses the resolution the scene is drawn at, as a fraction of the
+// output, from the GPU time of recent frames. Each frame is bracketed by
+// two GL_TIMESTAMP queries (they do not clash with the GL_TIME_ELAPSED
+// section timers) that are read QUERY_FRAMES frames later, never stalling.
+// Over budget the scale steps down, and once the GPU has clear headroom
+// it steps back up; the scene is then upscaled to the output in one blit.
+// Without `adaptive` the scale stays where it was set.
+class DynamicResolution {
+public:
+    static const int QUERY_FRAMES = 4;
+
+    DynamicResolution() = default;
+    ~DynamicResolution() { destroy(); }
+
+    void init(const DynamicResolutionConfig& config, bool adaptive, float startScale = 1.f);
+    void destroy();
+
+    // read back old timings and adjust the scale, then start this frame's
+    void beginFrame();
+    void endFrame();
+
+    float scale() const { return current; }
+    // smoothed GPU time of a whole frame, 0 until the first readback
+    double gpuMs() const { return smoothedMs; }
+    // size to draw at for an output of outW x outH, in whole 8 px blocks
+    void drawSize(int outW, int outH, int& w, int& h) const;
+
+private:
+    struct Frame {
+        GLuint Start = 0, End = 0;
+        bool   Issued = false;
+    };
+
+    DynamicResolutionConfig config;
+    bool   adaptive = false;
+    float  current = 1.f;
+    double smoothedMs = 0;
+    int    hold = 0;
+    Frame  frames[QUERY_FRAMES];
+    int    frame = 0;
+    bool   ready = false;
+};
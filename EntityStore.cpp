@@ -0,0 +1,108 @@
+#include "EntityStore.h"
+
+void EntityStore::setCapacity(size_t n) {
+    capacity = n;
+    Position.reserve(n);
+    PrevPosition.reserve(n);
+    Velocity.reserve(n);
+    Size.reserve(n);
+    TexID.reserve(n);
+    denseToSlot.reserve(n);
+    slotToDense.reserve(n);
+    generation.reserve(n);
+    freeSlots.reserve(n);
+}
+
+uint32_t EntityStore::allocSlot() {
+    if (!freeSlots.empty()) {
+        uint32_t slot = freeSlots.back();
+        freeSlots.pop_back();
+        return slot;
+    }
+    generation.push_back(0);
+    slotToDense.push_back(0);
+    return (uint32_t)(generation.size() - 1);
+}
+
+EntityHandle EntityStore::create(glm::vec2 pos, glm::vec2 vel, glm::vec2 size, unsigned int texID) {
+    if (full()) return EntityHandle{};
+    uint32_t slot = allocSlot();
+    slotToDense[slot] = (uint32_t)Position.size();
+    denseToSlot.push_back(slot);
+
+    Position.push_back(pos);
+    PrevPosition.push_back(pos);
+    Velocity.push_back(vel);
+    Size.push_back(size);
+    TexID.push_back(texID);
+    return EntityHandle{ slot, generation[slot] };
+}
+
+size_t EntityStore::createMany(const glm::vec2* pos, const glm::vec2* vel, const glm::vec2* size,
+        const unsigned int* texID, size_t n) {
+    size_t first = Position.size();
+    if (n > capacity - first) n = capacity - first;
+    Position.insert(Position.end(), pos, pos + n);
+    PrevPosition.insert(PrevPosition.end(), pos, pos + n);
+    Velocity.insert(Velocity.end(), vel, vel + n);
+    Size.insert(Size.end(), size, size + n);
+    TexID.insert(TexID.end(), texID, texID + n);
+    denseToSlot.resize(first + n);
+    for (size_t i = first; i < first + n; ++i) {
+        uint32_t slot = allocSlot();
+        slotToDense[slot] = (uint32_t)i;
+        denseToSlot[i] = slot;
+    }
+    return n;
+}
+
+void EntityStore::removeAt(size_t index) {
+    size_t last = Position.size() - 1;
+    uint32_t slot = denseToSlot[index];
+
+    if (index != last) {
+        Position[index] = Position[last];
+        PrevPosition[index] = PrevPosition[last];
+        Velocity[index] = Velocity[last];
+        Size[index] = Size[last];
+        TexID[index] = TexID[last];
+        denseToSlot[index] = denseToSlot[last];
+        slotToDense[denseToSlot[index]] = (uint32_t)index;
+    }
+    Position.pop_back();
+    PrevPosition.pop_back();
+    Velocity.pop_back();
+    Size.pop_back();
+    TexID.pop_back();
+    denseToSlot.pop_back();
+
+    // a bumped generation is what invalidates outstanding handles
+    generation[slot]++;
+    freeSlots.push_back(slot);
+}
+
+void EntityStore::remove(EntityHandle h) {
+    if (valid(h)) removeAt(slotToDense[h.Slot]);
+}
+
+void EntityStore::clear() {
+    for (uint32_t slot : denseToSlot) {
+        generation[slot]++;
+        freeSlots.push_back(slot);
+    }
+    Position.clear();
+    PrevPosition.clear();
+    Velocity.clear();
+    Size.clear();
+    TexID.clear();
+    denseToSlot.clear();
+}
+
+bool EntityStore::valid(EntityHandle h) const {
+    return h.Slot < generation.size() && generation[h.Slot] == h.Generation;
+}
+
+EntityHandle EntityStore::handleAt(size_t index) const {
+    uint32_t slot = denseToSlot[index];
+    return EntityHandle{ slot, generation[slot] };
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Stable reference to an entity. It stays valid until that entity is
+// removed; after that valid() is false even if the slot gets reused.
+struct EntityHandle {
+    uint32_t Slot = UINT32_MAX;
+    uint32_t Generation = 0;
+};
+
+// Structure-of-arrays storage for bullets and enemies. Each component is
+// its own packed array, indexed by the same dense index, so update loops
+// stream only the components they touch. Removal swaps the last entity into
+// the hole (O(1)); dense indices therefore change, handles do not.
+// With setCapacity() the store is a fixed-size pool: all memory is taken up
+// front and create() fails instead of growing.
+class EntityStore {
+public:
+    // packed components, all size() long
+    std::vector<glm::vec2>    Position;
+    std::vector<glm::vec2>    PrevPosition;   // Position at the start of the last tick
+    std::vector<glm::vec2>    Velocity;
+    std::vector<glm::vec2>    Size;
+    std::vector<unsigned int> TexID;
+
+    // allocate room for exactly `n` entities and never grow past it
+    void setCapacity(size_t n);
+
+    // returns an invalid handle (and creates nothing) when the pool is full
+    EntityHandle create(glm::vec2 pos, glm::vec2 vel, glm::vec2 size, unsigned int texID = 0);
+    // append `n` entities from parallel arrays in one pass, or as many as
+    // the pool has room for; returns how many were created
+    size_t createMany(const glm::vec2* pos, const glm::vec2* vel, const glm::vec2* size,
+        const unsigned int* texID, size_t n);
+
+    // swap-and-pop; when removing several entities in one pass, go from the
+    // highest dense index down so the ones still to visit do not move
+    void removeAt(size_t index);
+    void remove(EntityHandle h);
+    void clear();
+
+    bool valid(EntityHandle h) const;
+    // dense index of a valid handle
+    size_t indexOf(EntityHandle h) const { return slotToDense[h.Slot]; }
+    EntityHandle handleAt(size_t index) const;
+
+    size_t size() const { return Position.size(); }
+    bool empty() const { return Position.empty(); }
+    bool full() const { return Position.size() >= capacity; }
+
+    // snapshot Position into PrevPosition before integrating a tick
+    void savePositions() { PrevPosition = Position; }
+
+private:
+    uint32_t allocSlot();
+
+    size_t capacity = std::numeric_limits<size_t>::max();
+    std::vector<uint32_t> denseToSlot;
+    std::vector<uint32_t> slotToDense;
+    std::vector<uint32_t> generation;
+    std::vector<uint32_t> freeSlots;
+};
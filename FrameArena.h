@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+// Linear allocator for data that only lives until the end of the frame.
+// One block is allocated up front; alloc() bumps a pointer and reset()
+// frees everything at once. When a frame asks for more than the block
+// holds, alloc() returns nullptr and the request is remembered, and the
+// next reset() regrows the block, so a too-small arena costs one frame of
+// dropped data rather than a heap allocation in the middle of a frame.
+class FrameArena {
+public:
+    explicit FrameArena(size_t bytes) { regrow(bytes); }
+    ~FrameArena() { std::free(base); }
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    template <class T>
+    T* alloc(size_t count) {
+        size_t start = (used + alignof(T) - 1) & ~(alignof(T) - 1);
+        size_t end = start + count * sizeof(T);
+        if (end > capacity) {
+            if (end > wanted) wanted = end;
+            return nullptr;
+        }
+        used = end;
+        if (used > highWater) highWater = used;
+        return (T*)(base + start);
+    }
+
+    void reset() {
+        if (wanted > capacity) regrow(wanted * 2);
+        used = 0;
+        wanted = 0;
+    }
+
+    size_t bytesUsed() const { return used; }
+    size_t highWaterMark() const { return highWater; }
+    size_t bytesCapacity() const { return capacity; }
+
+private:
+    void regrow(size_t bytes) {
+        std::free(base);
+        base = (uint8_t*)std::malloc(bytes);
+        capacity = base ? bytes : 0;
+    }
+
+    uint8_t* base = nullptr;
+    size_t capacity = 0, used = 0, wanted = 0, highWater = 0;
+};
@@ -0,0 +1,70 @@
+#include "FramePacer.h"
+
+#include <cstring>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+FramePacer::~FramePacer() {
+#ifdef _WIN32
+    if (timerPeriodSet) timeEndPeriod(1);
+#endif
+}
+
+void FramePacer::init(PacingMode mode, double targetFps, bool adaptiveSupported) {
+    pacing = mode;
+    if (pacing == PacingMode::ADAPTIVE && !adaptiveSupported) pacing = PacingMode::VSYNC;
+    if (pacing == PacingMode::CAPPED && targetFps <= 0) pacing = PacingMode::UNCAPPED;
+    if (pacing == PacingMode::CAPPED) {
+        period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFps));
+        next = Clock::now();
+#ifdef _WIN32
+        // the default 15.6 ms timer would make every sleep miss the deadline
+        if (!timerPeriodSet) timerPeriodSet = timeBeginPeriod(1) == TIMERR_NOERROR;
+#endif
+    }
+}
+
+int FramePacer::swapInterval() const {
+    switch (pacing) {
+    case PacingMode::VSYNC: return 1;
+    case PacingMode::ADAPTIVE: return -1;
+    default: return 0;
+    }
+}
+
+double FramePacer::wait() {
+    if (pacing != PacingMode::CAPPED) return 0;
+    Clock::time_point start = Clock::now();
+    next += period;
+    // a frame that ran over starts the schedule afresh instead of
+    // rushing the following ones to catch up
+    if (next <= start) {
+        next = start;
+        return 0;
+    }
+    auto spinFrom = next - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(SPIN_MARGIN_MS));
+    if (spinFrom > start) std::this_thread::sleep_until(spinFrom);
+    while (Clock::now() < next) std::this_thread::yield();
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static const char* MODE_NAMES[] = { "vsync", "adaptive", "uncapped", "capped" };
+
+bool FramePacer::parseMode(const char* name, PacingMode& mode) {
+    for (int i = 0; i < 4; ++i) {
+        if (strcmp(name, MODE_NAMES[i]) == 0) {
+            mode = (PacingMode)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* FramePacer::modeName(PacingMode mode) {
+    return MODE_NAMES[(int)mode];
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+
+enum class PacingMode {
+    VSYNC,      // swap interval 1
+    ADAPTIVE,   // swap interval -1: vsync, but a late frame tears instead of waiting a whole refresh
+    UNCAPPED,   // swap interval 0, no waiting at all
+    CAPPED      // swap interval 0, frames started at a fixed rate by wait()
+};
+
+// Decides how frames are paced. The swap interval goes to the window
+// system; for CAPPED, wait() holds the thread until the next frame is due,
+// sleeping for most of the gap and spinning only for the last
+// SPIN_MARGIN_MS, since OS sleeps overshoot by up to a scheduler tick.
+// Call wait() right before input is polled, so the wait comes out of the
+// time between input and swap rather than adding to it.
+class FramePacer {
+public:
+    static constexpr double SPIN_MARGIN_MS = 1.5;
+
+    ~FramePacer();
+    // `adaptiveSupported`: the swap-control-tear extension is present;
+    // without it ADAPTIVE falls back to VSYNC
+    void init(PacingMode mode, double targetFps, bool adaptiveSupported);
+
+    PacingMode mode() const { return pacing; }
+    // for glfwSwapInterval
+    int swapInterval() const;
+    // true while the swap already blocks on the display
+    bool synced() const { return pacing == PacingMode::VSYNC || pacing == PacingMode::ADAPTIVE; }
+
+    // CAPPED: block until the next frame is due; returns the ms waited
+    double wait();
+
+    static bool parseMode(const char* name, PacingMode& mode);
+    static const char* modeName(PacingMode mode);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    PacingMode pacing = PacingMode::VSYNC;
+    Clock::duration period{};
+    Clock::time_point next;
+    bool timerPeriodSet = false;
+};
@@ -0,0 +1,223 @@
+#include "Headless.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+// a golden pixel matches when no channel is further off than this, and a
+// frame matches when at most 1 in GOLDEN_BAD_PIXELS_PER pixels does not
+static const int GOLDEN_CHANNEL_TOLERANCE = 8;
+static const int GOLDEN_BAD_PIXELS_PER = 1000;
+
+#ifdef __linux__
+bool HeadlessContext::init() {
+    EGLDisplay dpy = EGL_NO_DISPLAY;
+    // surfaceless needs no X, Wayland or DRM device at all
+    const char* clientExts = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay && clientExts && strstr(clientExts, "EGL_MESA_platform_surfaceless"))
+        dpy = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (dpy == EGL_NO_DISPLAY) dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, NULL, NULL)) {
+        fprintf(stderr, "Headless: no EGL display\n");
+        return false;
+    }
+    display = dpy;
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint count = 0;
+    if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(dpy, configAttribs, &config, 1, &count) || count == 0) {
+        fprintf(stderr, "Headless: no EGL config for desktop OpenGL\n");
+        return false;
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext ctx = eglCreateContext(dpy, config, EGL_NO_CONTEXT, contextAttribs);
+    if (ctx == EGL_NO_CONTEXT) {
+        fprintf(stderr, "Headless: cannot create a GL 3.3 core context\n");
+        return false;
+    }
+    context = ctx;
+
+    // everything is drawn into an FBO; the 1x1 pbuffer is only for
+    // drivers without EGL_KHR_surfaceless_context
+    EGLSurface surf = EGL_NO_SURFACE;
+    const char* dpyExts = eglQueryString(dpy, EGL_EXTENSIONS);
+    if (!dpyExts || !strstr(dpyExts, "EGL_KHR_surfaceless_context")) {
+        const EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        surf = eglCreatePbufferSurface(dpy, config, pbufferAttribs);
+        surface = surf;
+    }
+    if (!eglMakeCurrent(dpy, surf, surf, ctx)) {
+        fprintf(stderr, "Headless: eglMakeCurrent failed\n");
+        return false;
+    }
+    return true;
+}
+
+void HeadlessContext::shutdown() {
+    if (!display) return;
+    eglMakeCurrent((EGLDisplay)display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface) eglDestroySurface((EGLDisplay)display, (EGLSurface)surface);
+    if (context) eglDestroyContext((EGLDisplay)display, (EGLContext)context);
+    eglTerminate((EGLDisplay)display);
+    display = context = surface = nullptr;
+}
+
+void* HeadlessContext::getProcAddress(const char* name) {
+    return (void*)eglGetProcAddress(name);
+}
+#else
+bool HeadlessContext::init() {
+    fprintf(stderr, "Headless: only supported on Linux (EGL)\n");
+    return false;
+}
+void HeadlessContext::shutdown() {}
+void* HeadlessContext::getProcAddress(const char*) { return nullptr; }
+#endif
+
+FrameCapture::~FrameCapture() {
+    if (jobs)
+        for (Slot& s : slots) jobs->wait(s.Job);
+}
+
+bool FrameCapture::init(int width, int height, const char* out, const char* golden, JobSystem* jobSystem) {
+    w = width;
+    h = height;
+    outDir = out ? out : "";
+    goldenDir = golden ? golden : "";
+    jobs = jobSystem;
+    size_t bytes = (size_t)w * h * 4;
+    for (Slot& s : slots) {
+        s.Owner = this;
+        glGenBuffers(1, &s.Pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, s.Pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)bytes, nullptr, GL_STREAM_READ);
+        s.Pixels.resize(bytes);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return true;
+}
+
+void FrameCapture::capture(int frame) {
+    Slot& s = slots[next];
+    next = (next + 1) % CAPTURE_LATENCY;
+    if (s.Frame >= 0) collect(s);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s.Pbo);
+    glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    s.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    s.Frame = frame;
+}
+
+void FrameCapture::finish() {
+    for (int i = 0; i < CAPTURE_LATENCY; ++i) {
+        Slot& s = slots[(next + i) % CAPTURE_LATENCY];
+        if (s.Frame >= 0) collect(s);
+    }
+    for (Slot& s : slots) {
+        if (jobs) jobs->wait(s.Job);
+        tally(s);
+        if (s.Pbo) glDeleteBuffers(1, &s.Pbo);
+        s.Pbo = 0;
+    }
+}
+
+void FrameCapture::tally(Slot& s) {
+    if (s.Counted) return;
+    s.Counted = true;
+    if (goldenDir.empty()) return;
+    checked++;
+    if (s.Mismatch) failed++;
+}
+
+// map the slot's finished readback and hand it to a job
+void FrameCapture::collect(Slot& s) {
+    if (jobs) jobs->wait(s.Job);   // Pixels is free again
+    tally(s);
+
+    glClientWaitSync(s.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+    glDeleteSync(s.Fence);
+    s.Fence = nullptr;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s.Pbo);
+    const void* src = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)s.Pixels.size(), GL_MAP_READ_BIT);
+    if (src) {
+        memcpy(s.Pixels.data(), src, s.Pixels.size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    s.PixelsFrame = s.Frame;
+    s.Frame = -1;
+    s.Mismatch = false;
+    s.Counted = false;
+    if (jobs) jobs->submit(s.Job, processJob, &s);
+    else process(s);
+}
+
+void FrameCapture::processJob(void* ctx, size_t, size_t) {
+    Slot& s = *(Slot*)ctx;
+    s.Owner->process(s);
+}
+
+void FrameCapture::process(Slot& s) {
+    char path[512];
+    int stride = w * 4;
+    const uint8_t* topRow = s.Pixels.data() + (size_t)(h - 1) * stride;
+    if (!outDir.empty()) {
+        snprintf(path, sizeof(path), "%s/frame_%05d.png", outDir.c_str(), s.PixelsFrame);
+        if (!stbi_write_png(path, w, h, 4, topRow, -stride))
+            fprintf(stderr, "FrameCapture: cannot write %s\n", path);
+    }
+    if (goldenDir.empty()) return;
+
+    snprintf(path, sizeof(path), "%s/frame_%05d.png", goldenDir.c_str(), s.PixelsFrame);
+    int gw, gh, chan;
+    unsigned char* golden = stbi_load(path, &gw, &gh, &chan, 4);
+    if (!golden || gw != w || gh != h) {
+        printf("golden: frame %d: %s missing or not %dx%d\n", s.PixelsFrame, path, w, h);
+        s.Mismatch = true;
+        stbi_image_free(golden);
+        return;
+    }
+    // the golden file is top-down, the readback bottom-up
+    long bad = 0;
+    for (int y = 0; y < h; ++y) {
+        const uint8_t* a = topRow - (size_t)y * stride;
+        const uint8_t* b = golden + (size_t)y * stride;
+        for (int x = 0; x < w * 4; x += 4) {
+            for (int c = 0; c < 4; ++c) {
+                if (abs(a[x + c] - b[x + c]) > GOLDEN_CHANNEL_TOLERANCE) { bad++; break; }
+            }
+        }
+    }
+    stbi_image_free(golden);
+    if (bad > (long)w * h / GOLDEN_BAD_PIXELS_PER) {
+        printf("golden: frame %d differs in %ld pixels\n", s.PixelsFrame, bad);
+        s.Mismatch = true;
+    }
+}
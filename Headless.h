@@ -0,0 +1,75 @@
+#pragma once
+
+#include "JobSystem.h"
+#include "RenderTarget.h"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// GL 3.3 core context with no window, for CI boxes without a display.
+// Uses EGL: the Mesa surfaceless platform when present (works with
+// llvmpipe, LIBGL_ALWAYS_SOFTWARE=1), otherwise the default display with
+// a 1x1 pbuffer. Linux only; init() fails elsewhere.
+class HeadlessContext {
+public:
+    ~HeadlessContext() { shutdown(); }
+    bool init();
+    void shutdown();
+    // for gladLoadGLLoader and StreamBuffer
+    static void* getProcAddress(const char* name);
+
+private:
+    void* display = nullptr;
+    void* context = nullptr;
+    void* surface = nullptr;
+};
+
+// Reads frames back through a ring of pixel buffer objects: the copy
+// issued for frame N is only mapped CAPTURE_LATENCY frames later, when the
+// GPU is done with it, so readback never stalls the frame. Each frame is
+// then written as <dir>/frame_NNNNN.png and, with a golden directory,
+// compared against the PNG of the same name there; encoding and
+// comparing run as jobs.
+class FrameCapture {
+public:
+    static const int CAPTURE_LATENCY = 3;
+
+    ~FrameCapture();
+    // `outDir` or `goldenDir` may be null; `jobs` may have no workers
+    bool init(int width, int height, const char* outDir, const char* goldenDir, JobSystem* jobs);
+    // queue a readback of the currently bound read framebuffer
+    void capture(int frame);
+    // collect everything still in flight and free the buffers; call
+    // before the context goes away
+    void finish();
+
+    int framesChecked() const { return checked; }
+    int framesFailed() const { return failed; }
+
+private:
+    struct Slot {
+        GLuint Pbo = 0;
+        GLsync Fence = nullptr;
+        int    Frame = -1;
+        std::vector<uint8_t> Pixels;   // bottom-up, as read
+        int    PixelsFrame = -1;      // the frame in Pixels (Frame may be newer)
+        JobCounter Job;
+        bool   Mismatch = false;
+        bool   Counted = true;        // result already added to checked/failed
+        FrameCapture* Owner = nullptr;
+    };
+    void collect(Slot& s);
+    void tally(Slot& s);
+    static void processJob(void* ctx, size_t, size_t);
+    void process(Slot& s);
+
+    int w = 0, h = 0;
+    std::string outDir, goldenDir;
+    JobSystem* jobs = nullptr;
+    Slot slots[CAPTURE_LATENCY];
+    int next = 0;
+    int checked = 0, failed = 0;
+};
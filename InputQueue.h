@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// A key event as it arrived, before the simulation has placed it on a tick.
+struct InputEvent {
+    double TimeUs;   // gProfiler.nowUs() when the key callback saw it
+    int    Key;
+    int    Action;
+};
+
+// Single-producer (key callback) / single-consumer (simulation job) ring
+// of timestamped key events. Neither side ever blocks or locks, so the
+// callback can push while a worker is mid-tick, and events pushed between
+// two polls stay queued until a tick whose time span covers them.
+class InputQueue {
+public:
+    static const uint32_t SIZE = 256;   // power of two
+
+    // producer; false when full (the event is dropped and counted)
+    bool push(const InputEvent& e) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == SIZE) {
+            lost.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        ring[h & (SIZE - 1)] = e;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer; the oldest event, if it happened no later than `untilUs`
+    bool popUntil(double untilUs, InputEvent& out) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        const InputEvent& e = ring[t & (SIZE - 1)];
+        if (e.TimeUs > untilUs) return false;
+        out = e;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint64_t dropped() const { return lost.load(std::memory_order_relaxed); }
+
+private:
+    InputEvent ring[SIZE];
+    std::atomic<uint32_t> head{ 0 };   // written by the producer
+    std::atomic<uint32_t> tail{ 0 };   // written by the consumer
+    std::atomic<uint64_t> lost{ 0 };
+};
@@ -0,0 +1,118 @@
+#include "JobSystem.h"
+
+// the pool the current thread works for, and its deque there
+static thread_local JobSystem* currentPool = nullptr;
+static thread_local int currentWorker = -1;
+
+// attempts at finding work before a worker goes to sleep
+static const int SPIN_TRIES = 64;
+
+JobSystem::JobSystem(int workers) {
+    if (workers < 0) workers = 0;
+    for (int i = 0; i <= workers; ++i) queues.push_back(new Queue());
+    threads.reserve(workers);
+    for (int i = 0; i < workers; ++i)
+        threads.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        quit = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : threads) t.join();
+    for (Queue* q : queues) delete q;
+}
+
+void JobSystem::submit(JobCounter& counter, JobFn fn, void* ctx, size_t begin, size_t end) {
+    Job job{ fn, ctx, begin, end, &counter };
+    counter.Pending.fetch_add(1, std::memory_order_relaxed);
+    if (threads.empty()) {
+        execute(job);
+        return;
+    }
+
+    Queue& q = *queues[currentPool == this ? currentWorker : (int)threads.size()];
+    {
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.tail - q.head < QUEUE_SIZE) {
+            q.jobs[q.tail++ & (QUEUE_SIZE - 1)] = job;
+            job.Fn = nullptr;
+        }
+    }
+    if (job.Fn) {
+        execute(job);   // ring full
+        return;
+    }
+
+    queued.fetch_add(1);
+    if (sleepers.load() > 0) {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        wake.notify_one();
+    }
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    int self = currentPool == this ? currentWorker : (int)threads.size();
+    Job job;
+    while (!counter.done()) {
+        if (popOrSteal(self, job)) execute(job);
+        else std::this_thread::yield();
+    }
+}
+
+// own deque from the back (most recent, still in cache), then everyone
+// else's from the front (oldest, usually the biggest piece left)
+bool JobSystem::popOrSteal(int self, Job& job) {
+    int n = (int)queues.size();
+    {
+        Queue& q = *queues[self];
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.tail != q.head) {
+            job = q.jobs[--q.tail & (QUEUE_SIZE - 1)];
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    for (int k = 1; k < n; ++k) {
+        Queue& q = *queues[(self + k) % n];
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.tail != q.head) {
+            job = q.jobs[q.head++ & (QUEUE_SIZE - 1)];
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::execute(const Job& job) {
+    job.Fn(job.Ctx, job.Begin, job.End);
+    job.Counter->Pending.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::workerLoop(int index) {
+    currentPool = this;
+    currentWorker = index;
+    Job job;
+    int idle = 0;
+    while (!quit.load(std::memory_order_relaxed)) {
+        if (popOrSteal(index, job)) {
+            execute(job);
+            idle = 0;
+            continue;
+        }
+        if (++idle < SPIN_TRIES) {
+            std::this_thread::yield();
+            continue;
+        }
+        // a submit() either sees us in `sleepers` and notifies under the
+        // lock, or bumped `queued` before we check it here
+        std::unique_lock<std::mutex> guard(sleepLock);
+        sleepers.fetch_add(1);
+        wake.wait(guard, [this] { return queued.load() > 0 || quit.load(); });
+        sleepers.fetch_sub(1);
+        idle = 0;
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of jobs a JobSystem::submit() or parallelFor() is still waiting on.
+struct JobCounter {
+    std::atomic<int> Pending{ 0 };
+    bool done() const { return Pending.load(std::memory_order_acquire) == 0; }
+};
+
+// Small work-stealing job system. Every worker owns a deque: it pushes and
+// pops its own jobs at the back and steals from the front of the others
+// when it runs dry. Jobs pushed from outside the pool (the main thread) go
+// to one extra shared deque. A thread that waits on a counter runs jobs
+// in the meantime instead of blocking, so jobs may wait on jobs.
+//
+// Jobs are a function pointer plus a range, never a heap object, and the
+// deques are fixed rings, so scheduling does not allocate. When a ring is
+// full the job simply runs inline.
+class JobSystem {
+public:
+    typedef void (*JobFn)(void* ctx, size_t begin, size_t end);
+
+    // `workers` threads; 0 runs every job inline on the caller
+    explicit JobSystem(int workers);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    int workerCount() const { return (int)threads.size(); }
+
+    // run fn(ctx, begin, end) on some thread; `ctx` must outlive the job
+    void submit(JobCounter& counter, JobFn fn, void* ctx, size_t begin = 0, size_t end = 0);
+
+    // run jobs until `counter` reaches zero
+    void wait(JobCounter& counter);
+
+    // f(begin, end) over [0, count) in chunks of `grain`, returning when
+    // all chunks are done; the calling thread takes part
+    template <class F>
+    void parallelFor(size_t count, size_t grain, const F& f) {
+        if (threads.empty() || count <= grain) {
+            if (count) f((size_t)0, count);
+            return;
+        }
+        JobCounter counter;
+        JobFn tramp = [](void* ctx, size_t b, size_t e) { (*(const F*)ctx)(b, e); };
+        for (size_t b = 0; b < count; b += grain)
+            submit(counter, tramp, (void*)&f, b, b + grain < count ? b + grain : count);
+        wait(counter);
+    }
+
+private:
+    struct Job {
+        JobFn       Fn;
+        void*       Ctx;
+        size_t      Begin, End;
+        JobCounter* Counter;
+    };
+    static const size_t QUEUE_SIZE = 4096;   // power of two
+    struct Queue {
+        std::mutex lock;
+        Job        jobs[QUEUE_SIZE];
+        size_t     head = 0, tail = 0;   // front / back, both only grow
+    };
+
+    void workerLoop(int index);
+    bool popOrSteal(int self, Job& job);
+    void execute(const Job& job);
+
+    std::vector<Queue*>      queues;    // one per worker, then the shared one
+    std::vector<std::thread> threads;
+
+    std::atomic<int>  queued{ 0 };
+    std::atomic<int>  sleepers{ 0 };
+    std::atomic<bool> quit{ false };
+    std::mutex              sleepLock;
+    std::condition_variable wake;
+};
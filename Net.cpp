@@ -0,0 +1,620 @@
+#include "Net.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// bumped whenever a message or the snapshot layout changes
+const uint32_t NET_PROTOCOL = 1;
+// what an IPv4 + UDP header adds to every datagram on the wire
+const size_t UDP_IP_HEADER_BYTES = 28;
+// the client sends its inputs (and acks) at most this often
+const double INPUT_INTERVAL_MS = 1000.0 / 60.0;
+const double HELLO_INTERVAL_MS = 250.0;
+// further off than this, a reconciled ship counts as corrected
+const float CORRECTION_EPSILON = 0.5f;
+
+// Every datagram starts with its type:
+//   HELLO     u32 protocol                                   client -> host
+//   WELCOME   u32 protocol, u8 snapshot rate                 host -> client
+//   INPUT     varint newest snapshot tick + 1 (0 = none yet), u32 client ms,
+//             varint rtt ms, varint newest input seq, u8 count, then count
+//             inputs newest first, 2 bytes each              client -> host
+//   SNAPSHOT  u32 tick, varint ticks since the baseline (0 = none),
+//             varint next input seq to apply, varint ms the echoed client
+//             time was held + 1 (0 = none) and u32 that time, then the
+//             SnapshotCodec payload                          host -> client
+//   BYE       nothing; also the answer to a HELLO when the game is full
+enum : uint8_t { MSG_HELLO = 1, MSG_WELCOME, MSG_INPUT, MSG_SNAPSHOT, MSG_BYE };
+
+enum : uint8_t { INPUT_UP = 1, INPUT_DOWN = 2, INPUT_FIRE = 4 };
+
+static std::string addressText(const NetAddress& a) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u:%u", a.Ip >> 24, (a.Ip >> 16) & 255, (a.Ip >> 8) & 255, a.Ip & 255, a.Port);
+    return buf;
+}
+
+// ---- UdpSocket ----
+
+#ifdef _WIN32
+typedef SOCKET SocketHandle;
+typedef int socklen_t;
+static bool startSockets() {
+    static bool started = false;
+    if (!started) {
+        WSADATA data;
+        started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }
+    return started;
+}
+#else
+typedef int SocketHandle;
+#endif
+
+bool UdpSocket::open(uint16_t port) {
+    close();
+#ifdef _WIN32
+    if (!startSockets()) return false;
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_SOCKET) return false;
+    u_long nonBlocking = 1;
+    ioctlsocket(s, FIONBIO, &nonBlocking);
+#else
+    int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s < 0) return false;
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    sock = (intptr_t)s;
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(s, (const sockaddr*)&addr, sizeof(addr)) != 0) {
+        std::cerr << "Failed to bind UDP port " << port << "\n";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void UdpSocket::close() {
+    if (sock == -1) return;
+#ifdef _WIN32
+    closesocket((SOCKET)sock);
+#else
+    ::close((int)sock);
+#endif
+    sock = -1;
+}
+
+uint16_t UdpSocket::localPort() const {
+    sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (sock == -1 || getsockname((SocketHandle)sock, (sockaddr*)&addr, &len) != 0) return 0;
+    return ntohs(addr.sin_port);
+}
+
+bool UdpSocket::sendTo(const NetAddress& to, const void* data, size_t bytes) {
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(to.Ip);
+    addr.sin_port = htons(to.Port);
+    return sendto((SocketHandle)sock, (const char*)data, (int)bytes, 0, (const sockaddr*)&addr, sizeof(addr)) == (int)bytes;
+}
+
+int UdpSocket::recvFrom(NetAddress& from, void* buf, size_t capacity) {
+    if (sock == -1) return -1;
+    sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    // errors (nothing waiting, or an ICMP "port unreachable" from a peer
+    // that is not up yet) all read as no datagram
+    int n = (int)recvfrom((SocketHandle)sock, (char*)buf, (int)capacity, 0, (sockaddr*)&addr, &len);
+    if (n < 0) return -1;
+    from.Ip = ntohl(addr.sin_addr.s_addr);
+    from.Port = ntohs(addr.sin_port);
+    return n;
+}
+
+bool UdpSocket::resolve(const char* hostPort, NetAddress& out) {
+#ifdef _WIN32
+    if (!startSockets()) return false;
+#endif
+    const char* colon = strrchr(hostPort, ':');
+    if (!colon || colon == hostPort) return false;
+    char* end;
+    unsigned long port = strtoul(colon + 1, &end, 10);
+    if (*end || port == 0 || port > 65535) return false;
+
+    std::string name(hostPort, colon);
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(name.c_str(), nullptr, &hints, &found) != 0 || !found) return false;
+    out.Ip = ntohl(((const sockaddr_in*)found->ai_addr)->sin_addr.s_addr);
+    out.Port = (uint16_t)port;
+    freeaddrinfo(found);
+    return true;
+}
+
+void BandwidthMeter::add(size_t payload) {
+    Bytes += payload + UDP_IP_HEADER_BYTES;
+}
+
+void BandwidthMeter::update(double nowMs, NetStats& stats) {
+    if (WindowStartMs < 0) WindowStartMs = nowMs;
+    if (nowMs - WindowStartMs < 1000.0) return;
+    stats.KbitPerSec = Bytes * 8.0 / (nowMs - WindowStartMs);   // bits per ms = kbit/s
+    Bytes = 0;
+    WindowStartMs = nowMs;
+}
+
+static void recordSnapshot(NetStats& stats, size_t bytes, const WorldState& w) {
+    stats.SnapshotBytes = (uint32_t)bytes;
+    stats.PeakSnapshotBytes = std::max(stats.PeakSnapshotBytes, (uint32_t)bytes);
+    stats.Snapshots++;
+    stats.SnapshotTotalBytes += bytes;
+    stats.Entities = (uint32_t)(w.Enemies.size() + w.Bullets.size());
+}
+
+// ---- NetHost ----
+
+bool NetHost::open(uint16_t port, int snapshotRate, const SimConfig& config) {
+    if (!socket.open(port)) return false;
+    rate = std::min(std::max(snapshotRate, 1), (int)SIM_TICK_RATE);
+    size_t enemies = std::min(config.MaxEnemies, NET_MAX_ENTITIES);
+    size_t bullets = std::min(config.MaxBullets, NET_MAX_ENTITIES);
+    current.reserve(config.MaxEnemies, config.MaxBullets);
+    scratch.reserve(enemies, bullets);
+    for (WorldState& w : history) w.reserve(enemies, bullets);
+    std::cout << "net: hosting on UDP port " << socket.localPort() << ", " << rate << " snapshots/s\n";
+    return true;
+}
+
+void NetHost::close() {
+    if (!isOpen()) return;
+    if (hasClient) {
+        uint8_t bye = MSG_BYE;
+        socket.sendTo(client, &bye, 1);
+    }
+    hasClient = false;
+    netStats.Connected = false;
+    socket.close();
+}
+
+void NetHost::drop(const char* why) {
+    std::cout << "net: partner " << addressText(client) << " " << why << "\n";
+    hasClient = false;
+    netStats.Connected = false;
+    // the partner's ship stays where it was, and its leftover inputs go
+    pendingHead = pendingTail = 0;
+}
+
+void NetHost::update(const Simulation& sim, uint8_t phase, double nowMs) {
+    if (!isOpen()) return;
+    receive(nowMs);
+    if (hasClient && nowMs - lastHeardMs > NET_TIMEOUT_MS) drop("timed out");
+    if (hasClient && nowMs >= nextSnapshotMs) {
+        double interval = 1000.0 / rate;
+        // a hitch skips the snapshots it missed instead of bursting them
+        nextSnapshotMs = nowMs - nextSnapshotMs > interval ? nowMs + interval : nextSnapshotMs + interval;
+        sendSnapshot(sim, phase, nowMs);
+    }
+    meter.update(nowMs, netStats);
+}
+
+void NetHost::receive(double nowMs) {
+    NetAddress from;
+    int n;
+    while ((n = socket.recvFrom(from, packet, sizeof(packet))) >= 0) {
+        ByteReader in(packet, (size_t)n);
+        uint8_t type = in.u8();
+        if (type == MSG_HELLO) {
+            if (in.u32() != NET_PROTOCOL || !in.ok()) continue;
+            if (hasClient && from != client) {
+                uint8_t full = MSG_BYE;
+                socket.sendTo(from, &full, 1);
+                continue;
+            }
+            if (!hasClient) {
+                // a new partner: nothing it could acknowledge, no inputs yet
+                client = from;
+                hasClient = true;
+                netStats.Connected = true;
+                sentCount = 0;
+                hasAck = false;
+                seqKnown = false;
+                pendingHead = pendingTail = 0;
+                echoArrivedMs = -1;
+                nextSnapshotMs = nowMs;
+                std::cout << "net: partner joined from " << addressText(client) << "\n";
+            }
+            lastHeardMs = nowMs;
+            uint8_t welcome[6];
+            ByteWriter w(welcome, sizeof(welcome));
+            w.u8(MSG_WELCOME);
+            w.u32(NET_PROTOCOL);
+            w.u8((uint8_t)rate);
+            socket.sendTo(client, welcome, w.size());
+            continue;
+        }
+        if (!hasClient || from != client) continue;
+        lastHeardMs = nowMs;
+        if (type == MSG_INPUT) readInputs(in, nowMs);
+        else if (type == MSG_BYE) drop("left");
+    }
+}
+
+void NetHost::readInputs(ByteReader& in, double nowMs) {
+    uint64_t ack = in.varint();
+    uint32_t clientMs = in.u32();
+    uint64_t rtt = in.varint();
+    uint32_t newestSeq = (uint32_t)in.varint();
+    uint8_t count = in.u8();
+    const uint8_t* bytes = in.take(2 * (size_t)count);
+    if (!in.ok() || count > NetClient::INPUTS_PER_PACKET) return;
+
+    // UDP may reorder; only ever move forward
+    if (ack && (!hasAck || (int32_t)((uint32_t)(ack - 1) - ackedTick) > 0)) {
+        ackedTick = (uint32_t)(ack - 1);
+        hasAck = true;
+    }
+    echoTime = clientMs;
+    echoArrivedMs = nowMs;
+    netStats.RttMs = (double)rtt;
+    if (!count) return;
+
+    uint32_t oldest = newestSeq - count + 1;
+    if (!seqKnown) {
+        nextSeq = appliedSeq = oldest;
+        seqKnown = true;
+    }
+    for (uint32_t k = count; k-- > 0;) {
+        uint32_t seq = newestSeq - k;
+        if ((int32_t)(seq - nextSeq) < 0) continue;   // queued already
+        // full: leave it for the copy of it in the client's next packet
+        if (pendingHead - pendingTail == PENDING_INPUTS) break;
+        // a gap means inputs lost beyond the redundancy; the client's
+        // reconciliation absorbs them
+        const uint8_t* b = bytes + 2 * k;
+        SimInput i;
+        i.Up = (b[0] & INPUT_UP) != 0;
+        i.Down = (b[0] & INPUT_DOWN) != 0;
+        i.Fire = (b[0] & INPUT_FIRE) != 0;
+        i.FireAt = b[1] / 255.f;
+        pending[pendingHead++ & (PENDING_INPUTS - 1)] = PendingInput{ seq, i };
+        nextSeq = seq + 1;
+    }
+}
+
+size_t NetHost::takeInputs(SimInput* out, size_t max) {
+    size_t n = 0;
+    for (; n < max && pendingTail != pendingHead; ++n) {
+        const PendingInput& p = pending[pendingTail++ & (PENDING_INPUTS - 1)];
+        out[n] = p.Input;
+        appliedSeq = p.Seq + 1;
+    }
+    return n;
+}
+
+void NetHost::sendSnapshot(const Simulation& sim, uint8_t phase, double nowMs) {
+    // the same tick again has nothing new to say
+    if (sentCount && history[(sentCount - 1) % HISTORY].Tick == (uint32_t)sim.Tick) return;
+    captureWorld(sim, phase, current);
+    const WorldState* base = nullptr;
+    if (hasAck) {
+        for (uint32_t i = 0; i < std::min<uint32_t>(sentCount, HISTORY); ++i) {
+            const WorldState& w = history[(sentCount - 1 - i) % HISTORY];
+            if (w.Tick == ackedTick) {
+                base = &w;
+                break;
+            }
+        }
+    }
+
+    ByteWriter w(packet, sizeof(packet));
+    w.u8(MSG_SNAPSHOT);
+    w.u32(current.Tick);
+    w.varint(base ? current.Tick - base->Tick : 0);
+    w.varint(seqKnown ? appliedSeq : 0);
+    if (echoArrivedMs >= 0) {
+        w.varint((uint64_t)(nowMs - echoArrivedMs) + 1);
+        w.u32(echoTime);
+    }
+    else w.varint(0);
+    codec.encode(current, base, w, scratch);
+    // the slot being replaced may have been the baseline, so only now
+    std::swap(history[sentCount % HISTORY], scratch);
+    sentCount++;
+
+    socket.sendTo(client, packet, w.size());
+    meter.add(w.size());
+    recordSnapshot(netStats, w.size(), history[(sentCount - 1) % HISTORY]);
+}
+
+// ---- NetClient ----
+
+NetClient::NetClient() {
+    // the partner's ship as the simulation lays it out
+    SimConfig config;
+    config.MaxBullets = config.MaxEnemies = 1;
+    config.Coop = true;
+    Simulation layout(0, config);
+    predicted = layout.Partner;
+    prevPredicted = predicted.Position;
+    scratch.reserve(NET_MAX_ENTITIES, NET_MAX_ENTITIES);
+    for (WorldState& w : history) w.reserve(NET_MAX_ENTITIES, NET_MAX_ENTITIES);
+    removed.reserve(NET_MAX_ENTITIES);
+    Kills.reserve(NET_MAX_ENTITIES);
+}
+
+bool NetClient::open(const char* hostPort) {
+    if (!UdpSocket::resolve(hostPort, host)) {
+        std::cerr << "Cannot resolve " << hostPort << " (expected host:port)\n";
+        return false;
+    }
+    if (!socket.open(0)) return false;
+    // seqs start at 1, so an acknowledged 0 means none applied yet
+    nextSeq = 1;
+    std::cout << "net: joining " << addressText(host) << "\n";
+    return true;
+}
+
+void NetClient::close() {
+    if (!isOpen()) return;
+    uint8_t bye = MSG_BYE;
+    socket.sendTo(host, &bye, 1);
+    socket.close();
+    netStats.Connected = false;
+}
+
+void NetClient::tick(const SimInput& in) {
+    prevPredicted = predicted.Position;
+    inputs[nextSeq & (INPUT_HISTORY - 1)] = in;
+    nextSeq++;
+    Simulation::steer(predicted, in);
+}
+
+void NetClient::update(double nowMs) {
+    if (!isOpen()) return;
+    if (openedMs < 0) {
+        openedMs = nowMs;
+        lastHeardMs = nowMs;
+    }
+    receive(nowMs);
+    if (welcomed && nowMs - lastHeardMs > NET_TIMEOUT_MS) {
+        std::cout << "net: lost the host, rejoining\n";
+        welcomed = false;
+        netStats.Connected = false;
+    }
+    if (!welcomed) {
+        if (nowMs - lastSentMs >= HELLO_INTERVAL_MS) {
+            uint8_t hello[5];
+            ByteWriter w(hello, sizeof(hello));
+            w.u8(MSG_HELLO);
+            w.u32(NET_PROTOCOL);
+            socket.sendTo(host, hello, w.size());
+            lastSentMs = nowMs;
+        }
+    }
+    else if (nowMs - lastSentMs >= INPUT_INTERVAL_MS) sendInputs(nowMs);
+    meter.update(nowMs, netStats);
+}
+
+void NetClient::receive(double nowMs) {
+    NetAddress from;
+    int n;
+    while ((n = socket.recvFrom(from, packet, sizeof(packet))) >= 0) {
+        if (from != host) continue;
+        ByteReader in(packet, (size_t)n);
+        uint8_t type = in.u8();
+        if (type == MSG_WELCOME) {
+            uint32_t protocol = in.u32();
+            int hostRate = in.u8();
+            if (!in.ok() || protocol != NET_PROTOCOL || hostRate == 0) {
+                std::cerr << "net: the host runs a different version of the game\n";
+                close();
+                return;
+            }
+            if (!welcomed) std::cout << "net: joined, " << hostRate << " snapshots/s\n";
+            welcomed = true;
+            rate = hostRate;
+            lastHeardMs = nowMs;
+        }
+        else if (type == MSG_SNAPSHOT) {
+            meter.add((size_t)n);
+            lastHeardMs = nowMs;
+            if (readSnapshot(in, nowMs)) recordSnapshot(netStats, (size_t)n, *newest);
+        }
+        else if (type == MSG_BYE) {
+            std::cout << (welcomed ? "net: the host ended the game\n" : "net: the host's game is full\n");
+            welcomed = false;
+            netStats.Connected = false;
+            close();
+            return;
+        }
+    }
+}
+
+const WorldState* NetClient::findTick(uint32_t tick) const {
+    for (uint32_t i = 0; i < std::min<uint32_t>(received, HISTORY); ++i) {
+        const WorldState& w = history[(received - 1 - i) % HISTORY];
+        if (w.Tick == tick) return &w;
+    }
+    return nullptr;
+}
+
+bool NetClient::readSnapshot(ByteReader& in, double nowMs) {
+    uint32_t tick = in.u32();
+    uint64_t sinceBase = in.varint();
+    uint32_t ackSeq = (uint32_t)in.varint();
+    uint64_t held = in.varint();
+    uint32_t echo = held ? in.u32() : 0;
+    if (!in.ok()) return false;
+    // late or duplicated
+    if (newest && (int32_t)(tick - newest->Tick) <= 0) return false;
+    const WorldState* base = nullptr;
+    if (sinceBase) {
+        base = findTick(tick - (uint32_t)sinceBase);
+        if (!base) return false;   // too old to decode; a later one will be against a newer ack
+    }
+    removed.clear();
+    if (!codec.decode(in, base, tick, scratch, &removed)) return false;
+
+    // name every entity that just appeared, so interpolation never blends
+    // two that shared a slot
+    for (NetEntity& e : scratch.Enemies)
+        if (!e.Generation) e.Generation = ++freshGeneration;
+    for (NetEntity& e : scratch.Bullets) {
+        if (e.Generation) continue;
+        e.Generation = ++freshGeneration;
+        if (base) Shots++;
+    }
+    // enemies gone while still on screen were shot down, not flown past
+    int64_t ticks = base ? (int64_t)tick - base->Tick : 0;
+    for (const NetEntity& e : removed) {
+        float x = predictPosition(e.X, e.VX, ticks) / NET_POS_SCALE;
+        float y = predictPosition(e.Y, e.VY, ticks) / NET_POS_SCALE;
+        if (x + e.W > 0.f && Kills.size() < Kills.capacity())
+            Kills.push_back(glm::vec2(x + e.W / 2.f, y + e.H / 2.f));
+    }
+
+    std::swap(history[received % HISTORY], scratch);
+    newest = &history[received % HISTORY];
+    received++;
+    netStats.Connected = true;
+
+    if (held) {
+        double rtt = (nowMs - openedMs) - echo - (double)(held - 1);
+        rtt = std::max(rtt, 0.0);
+        netStats.RttMs = netStats.Snapshots ? netStats.RttMs + (rtt - netStats.RttMs) * 0.1 : rtt;
+    }
+    // host tick = now * ticks per ms + offset; follow it slowly, but jump
+    // after a stall rather than drift back over seconds
+    double offset = tick - nowMs * SIM_TICK_RATE / 1000.0;
+    if (!clockKnown || std::abs(offset - tickOffset) > SIM_TICK_RATE / 2) tickOffset = offset;
+    else tickOffset += (offset - tickOffset) * 0.05;
+    clockKnown = true;
+
+    reconcile(newest->Ships[1], ackSeq);
+    return true;
+}
+
+void NetClient::reconcile(const NetShip& authoritative, uint32_t ackSeq) {
+    // where the host had the ship, then every input it has not applied
+    // yet, in order, exactly as its simulation will apply them
+    Entity replay = predicted;
+    replay.Position = glm::vec2(authoritative.X, authoritative.Y);
+    uint32_t from = ackSeq ? ackSeq : 1;
+    if (nextSeq - from <= INPUT_HISTORY)
+        for (uint32_t s = from; s != nextSeq; ++s) Simulation::steer(replay, inputs[s & (INPUT_HISTORY - 1)]);
+
+    glm::vec2 delta = replay.Position - predicted.Position;
+    float error = glm::length(delta);
+    if (placed && error > CORRECTION_EPSILON) {
+        netStats.Corrections++;
+        netStats.LastCorrection = error;
+    }
+    predicted.Position = replay.Position;
+    prevPredicted = placed ? prevPredicted + delta : replay.Position;
+    placed = true;
+}
+
+void NetClient::sendInputs(double nowMs) {
+    ByteWriter w(packet, sizeof(packet));
+    w.u8(MSG_INPUT);
+    w.varint(newest ? (uint64_t)newest->Tick + 1 : 0);
+    w.u32((uint32_t)(nowMs - openedMs));
+    w.varint((uint64_t)netStats.RttMs);
+    uint32_t newestSeq = nextSeq - 1;
+    uint32_t count = std::min<uint32_t>((uint32_t)INPUTS_PER_PACKET, newestSeq);
+    w.varint(newestSeq);
+    w.u8((uint8_t)count);
+    for (uint32_t k = 0; k < count; ++k) {
+        const SimInput& i = inputs[(newestSeq - k) & (INPUT_HISTORY - 1)];
+        w.u8((uint8_t)((i.Up ? INPUT_UP : 0) | (i.Down ? INPUT_DOWN : 0) | (i.Fire ? INPUT_FIRE : 0)));
+        w.u8((uint8_t)std::lround(std::min(std::max(i.FireAt, 0.f), 1.f) * 255.f));
+    }
+    socket.sendTo(host, packet, w.size());
+    lastSentMs = nowMs;
+}
+
+static glm::vec2 entityPosition(const NetEntity& e, double ticks) {
+    return glm::vec2((float)(e.X + e.VX * ticks / SIM_TICK_RATE), (float)(e.Y + e.VY * ticks / SIM_TICK_RATE)) / NET_POS_SCALE;
+}
+
+static void addEntity(EntityStore& store, const NetEntity& e, glm::vec2 pos) {
+    store.create(pos, glm::vec2(e.VX, e.VY) / NET_VEL_SCALE, glm::vec2(e.W, e.H), e.Tex);
+}
+
+// every entity of `a` at `t` (0..1) of the way to `b`; one only `a` has
+// flies on from it, one only `b` has is not there yet
+static void blendList(const std::vector<NetEntity>& a, const std::vector<NetEntity>* b, double ticks, float t,
+    EntityStore& out) {
+    size_t j = 0;
+    for (const NetEntity& e : a) {
+        if (b) {
+            while (j < b->size() && (*b)[j].Id < e.Id) j++;
+            if (j < b->size() && (*b)[j].Id == e.Id && (*b)[j].Generation == e.Generation) {
+                const NetEntity& f = (*b)[j];
+                glm::vec2 pa(e.X / NET_POS_SCALE, e.Y / NET_POS_SCALE), pb(f.X / NET_POS_SCALE, f.Y / NET_POS_SCALE);
+                addEntity(out, f, glm::mix(pa, pb, t));
+                continue;
+            }
+        }
+        addEntity(out, e, entityPosition(e, ticks));
+    }
+}
+
+void NetClient::interpolate(double nowMs, glm::vec2& hostShip, EntityStore& enemies, EntityStore& bullets) const {
+    enemies.clear();
+    bullets.clear();
+    if (!newest) return;
+
+    double delay = INTERPOLATION_INTERVALS * SIM_TICK_RATE / rate;
+    double renderTick = nowMs * SIM_TICK_RATE / 1000.0 + tickOffset - delay;
+
+    // the last snapshot at or before renderTick, and the one after it
+    uint32_t count = std::min<uint32_t>(received, HISTORY);
+    const WorldState* a = &history[(received - count) % HISTORY];
+    const WorldState* b = nullptr;
+    for (uint32_t i = received - count; i != received; ++i) {
+        const WorldState& w = history[i % HISTORY];
+        if (w.Tick <= renderTick) a = &w;
+        else {
+            if (w.Tick > a->Tick) b = &w;
+            break;
+        }
+    }
+    // past the newest snapshot: extrapolate, but not far
+    double ticks = std::min(std::max(renderTick - a->Tick, 0.0), delay);
+    float t = b ? (float)((renderTick - a->Tick) / (b->Tick - a->Tick)) : 0.f;
+    t = std::min(std::max(t, 0.f), 1.f);
+
+    glm::vec2 sa(a->Ships[0].X, a->Ships[0].Y);
+    hostShip = b ? glm::mix(sa, glm::vec2(b->Ships[0].X, b->Ships[0].Y), t) : sa;
+    blendList(a->Enemies, b ? &b->Enemies : nullptr, ticks, t, enemies);
+    blendList(a->Bullets, b ? &b->Bullets : nullptr, ticks, t, bullets);
+}
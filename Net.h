@@ -0,0 +1,237 @@
+#pragma once
+
+#include "Simulation.h"
+#include "Snapshot.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// IPv4 address and port, host byte order
+struct NetAddress {
+    uint32_t Ip = 0;
+    uint16_t Port = 0;
+
+    bool operator==(const NetAddress& o) const { return Ip == o.Ip && Port == o.Port; }
+    bool operator!=(const NetAddress& o) const { return !(*this == o); }
+};
+
+// Non-blocking UDP socket: Winsock on Windows, BSD sockets elsewhere.
+class UdpSocket {
+public:
+    UdpSocket() = default;
+    ~UdpSocket() { close(); }
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    // bind to `port` on every interface; 0 picks a free one
+    bool open(uint16_t port);
+    void close();
+    bool isOpen() const { return sock != -1; }
+    uint16_t localPort() const;
+
+    bool sendTo(const NetAddress& to, const void* data, size_t bytes);
+    // one waiting datagram; -1 when there is none
+    int recvFrom(NetAddress& from, void* buf, size_t capacity);
+
+    // "host:port", by name or dotted quad
+    static bool resolve(const char* hostPort, NetAddress& out);
+
+private:
+    intptr_t sock = -1;   // a SOCKET on Windows
+};
+
+// snapshots per second unless --net-rate says otherwise
+const int NET_DEFAULT_RATE = 20;
+// silence after which the other side counts as gone
+const double NET_TIMEOUT_MS = 3000.0;
+
+// What the F3 overlay and the exit summary show about the connection.
+struct NetStats {
+    bool     Connected = false;
+    uint32_t SnapshotBytes = 0;      // the last snapshot's payload
+    uint32_t PeakSnapshotBytes = 0;
+    uint64_t Snapshots = 0;
+    uint64_t SnapshotTotalBytes = 0;
+    double   KbitPerSec = 0;         // snapshots over the last second, with UDP/IP headers
+    double   RttMs = 0;              // smoothed
+    uint32_t Entities = 0;           // enemies and bullets in the last snapshot
+    uint64_t Corrections = 0;        // times the partner's prediction was off by more than half a pixel
+    float    LastCorrection = 0.f;   // by how much, in px
+};
+
+// Counts datagram bytes and turns them into kbit/s once a second.
+struct BandwidthMeter {
+    double   WindowStartMs = -1;
+    uint64_t Bytes = 0;
+
+    void add(size_t payload);
+    // closes the window once a second, into stats.KbitPerSec
+    void update(double nowMs, NetStats& stats);
+};
+
+// The authoritative side of a co-op game. The host runs the only real
+// simulation; the partner's ship in it is flown by the inputs its client
+// sends, each applied on exactly one tick. Every 1/rate s the world goes
+// out quantized and delta-compressed (see SnapshotCodec) against the last
+// snapshot the client acknowledged.
+//
+// Like the simulation, a NetHost belongs to the sim job while it runs:
+// update() on the main thread between jobs.wait() and the next submit,
+// takeInputs() inside the job.
+class NetHost {
+public:
+    static const size_t MAX_INPUTS_PER_TICK = 4;   // how fast a backlog of partner inputs drains
+    static const size_t HISTORY = 16;              // sent snapshots a client may acknowledge
+    static const size_t PENDING_INPUTS = 64;       // power of two
+
+    NetHost() = default;
+    ~NetHost() { close(); }
+
+    // listen on `port`, sending `rate` snapshots a second of a simulation
+    // made with `config`
+    bool open(uint16_t port, int rate, const SimConfig& config);
+    void close();
+    bool isOpen() const { return socket.isOpen(); }
+    bool connected() const { return hasClient; }
+    uint16_t port() const { return socket.localPort(); }
+
+    // read the client's packets, then send a snapshot of `sim` if one is due
+    void update(const Simulation& sim, uint8_t phase, double nowMs);
+    // the partner's inputs for the tick about to run, oldest first
+    size_t takeInputs(SimInput* out, size_t max);
+
+    const NetStats& stats() const { return netStats; }
+    // what the client decodes from the last snapshot sent, nullptr before any
+    const WorldState* lastSent() const { return sentCount ? &history[(sentCount - 1) % HISTORY] : nullptr; }
+
+private:
+    struct PendingInput {
+        uint32_t Seq;
+        SimInput Input;
+    };
+
+    void receive(double nowMs);
+    void readInputs(ByteReader& in, double nowMs);
+    void sendSnapshot(const Simulation& sim, uint8_t phase, double nowMs);
+    void drop(const char* why);
+
+    UdpSocket  socket;
+    NetAddress client;
+    bool       hasClient = false;
+    double     lastHeardMs = 0;
+    int        rate = NET_DEFAULT_RATE;
+    double     nextSnapshotMs = 0;
+
+    SnapshotCodec codec;
+    WorldState    current, scratch;
+    WorldState    history[HISTORY];
+    uint32_t      sentCount = 0;      // snapshots sent to this client; history[n % HISTORY]
+    bool          hasAck = false;
+    uint32_t      ackedTick = 0;      // newest snapshot the client has decoded
+
+    // inputs received and not yet applied, and the sequence numbers
+    // around them; seqs start wherever the client's do
+    PendingInput pending[PENDING_INPUTS];
+    uint32_t     pendingHead = 0, pendingTail = 0;
+    bool         seqKnown = false;
+    uint32_t     nextSeq = 0;        // next one to queue
+    uint32_t     appliedSeq = 0;     // next one the simulation will apply
+    uint32_t     echoTime = 0;       // the client's clock in its newest packet, sent back
+    double       echoArrivedMs = -1;
+
+    NetStats       netStats;
+    BandwidthMeter meter;
+    uint8_t        packet[NET_MAX_PACKET];
+};
+
+// The other player. It runs no simulation of its own: its ship moves
+// under its inputs at once (prediction) and is put back on the host's
+// track whenever a snapshot says where the host had it, with the inputs
+// the host has not applied yet replayed on top (reconciliation). Everything
+// else is drawn a little in the past, interpolated between the two
+// snapshots around that moment.
+//
+// tick() runs inside the sim job, update() and interpolate() on the main
+// thread between jobs, as for NetHost.
+class NetClient {
+public:
+    static const size_t HISTORY = 16;           // decoded snapshots kept, for baselines and interpolation
+    static const size_t INPUT_HISTORY = 128;    // power of two
+    static const size_t INPUTS_PER_PACKET = 16; // the newest, again and again, against loss
+    // drawn this many snapshot intervals behind the newest, so there is
+    // nearly always a later snapshot to interpolate towards
+    static const int INTERPOLATION_INTERVALS = 2;
+
+    NetClient();
+    ~NetClient() { close(); }
+
+    bool open(const char* hostPort);
+    void close();
+    bool isOpen() const { return socket.isOpen(); }
+    bool connected() const { return netStats.Connected; }
+
+    // one tick of the local player's input, applied to the ship right away
+    void tick(const SimInput& in);
+    // send inputs (or ask to join), take in snapshots and reconcile
+    void update(double nowMs);
+    // the world as it stood one interpolation delay ago: the host's ship,
+    // and every enemy and bullet into `enemies` and `bullets`
+    void interpolate(double nowMs, glm::vec2& hostShip, EntityStore& enemies, EntityStore& bullets) const;
+
+    // the predicted ship, now and a tick ago
+    const Entity& ship() const { return predicted; }
+    glm::vec2 prevShipPosition() const { return prevPredicted; }
+    // tick() calls so far
+    uint64_t ticks() const { return nextSeq - 1; }
+
+    // the newest snapshot's game state
+    uint8_t  phase() const { return newest ? newest->Phase : 0; }
+    uint32_t score() const { return newest ? newest->Score : 0; }
+    int32_t  health() const { return newest ? newest->Health : 0; }
+
+    // since the last call: enemies that went down on screen, and new bullets
+    std::vector<glm::vec2> Kills;
+    unsigned int           Shots = 0;
+
+    const NetStats& stats() const { return netStats; }
+    const WorldState* lastReceived() const { return newest; }
+
+private:
+    void receive(double nowMs);
+    bool readSnapshot(ByteReader& in, double nowMs);
+    void reconcile(const NetShip& authoritative, uint32_t ackSeq);
+    void sendInputs(double nowMs);
+    const WorldState* findTick(uint32_t tick) const;
+
+    UdpSocket  socket;
+    NetAddress host;
+    bool       welcomed = false;
+    double     openedMs = -1;
+    double     lastHeardMs = 0, lastSentMs = -1e9;
+    int        rate = NET_DEFAULT_RATE;
+
+    Entity    predicted;
+    glm::vec2 prevPredicted;
+    bool      placed = false;   // put where the host has it yet
+    SimInput  inputs[INPUT_HISTORY];
+    uint32_t  nextSeq = 0;      // of the next tick()
+    uint32_t  sentSeq = 0;      // newest seq sent, + 1
+
+    SnapshotCodec codec;
+    WorldState    scratch;
+    WorldState    history[HISTORY];   // ascending ticks, oldest at received % HISTORY
+    uint32_t      received = 0;
+    const WorldState* newest = nullptr;
+    uint32_t      freshGeneration = 0;   // tells a reused slot apart, as the host's generations did
+    std::vector<NetEntity> removed;
+
+    // host ticks per ms are fixed; this is where the host's clock stands
+    // against ours, smoothed
+    double tickOffset = 0;
+    bool   clockKnown = false;
+
+    NetStats       netStats;
+    BandwidthMeter meter;
+    uint8_t        packet[NET_MAX_PACKET];
+};
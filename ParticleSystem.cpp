@@ -0,0 +1,165 @@
+#include "ParticleSystem.h"
+
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define PARTICLES_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLES_SSE 1
+#endif
+
+template <class F>
+static void parallelFor(JobSystem* jobs, size_t count, size_t grain, const F& f) {
+    if (jobs) jobs->parallelFor(count, grain, f);
+    else if (count) f((size_t)0, count);
+}
+
+static float uniform(Rng& rng, float lo, float hi) {
+    return lo + (hi - lo) * (rng.next() >> 8) * (1.f / 16777216.f);
+}
+
+ParticleSystem::ParticleSystem(size_t cap, uint64_t seed) : rng(seed) {
+    setCapacity(cap);
+}
+
+void ParticleSystem::setCapacity(size_t cap) {
+    for (std::vector<float>* a : { &PosX, &PosY, &VelX, &VelY, &Life, &InvSpan, &Size })
+        a->assign(cap, 0.f);
+    Color.assign(cap, 0);
+    chunkAlive.assign(cap / UPDATE_GRAIN + 1, 0);
+    count = 0;
+}
+
+void ParticleSystem::emit(glm::vec2 pos, const ParticleBurst& b) {
+    size_t n = (size_t)(b.Count > 0 ? b.Count : 0);
+    if (count + n > capacity()) {
+        lost += count + n - capacity();
+        n = capacity() - count;
+    }
+    for (size_t i = count; i < count + n; ++i) {
+        float a = b.Angle + uniform(rng, -0.5f, 0.5f) * b.Spread;
+        float speed = uniform(rng, b.SpeedMin, b.SpeedMax);
+        float life = uniform(rng, b.LifeMin, b.LifeMax);
+        PosX[i] = pos.x;
+        PosY[i] = pos.y;
+        VelX[i] = b.Velocity.x + std::cos(a) * speed;
+        VelY[i] = b.Velocity.y + std::sin(a) * speed;
+        Life[i] = life;
+        InvSpan[i] = 1.f / life;
+        Size[i] = uniform(rng, b.SizeMin, b.SizeMax);
+        Color[i] = b.Color;
+    }
+    count += n;
+}
+
+// p += v * dt, v *= damp, life -= dt over [0, n)
+static void integrate(float* px, float* py, float* vx, float* vy, float* life, size_t n, float dt, float damp) {
+    size_t i = 0;
+#if PARTICLES_AVX
+    __m256 vdt = _mm256_set1_ps(dt), vdamp = _mm256_set1_ps(damp);
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(px + i), y = _mm256_loadu_ps(py + i);
+        __m256 u = _mm256_loadu_ps(vx + i), v = _mm256_loadu_ps(vy + i);
+        _mm256_storeu_ps(px + i, _mm256_add_ps(x, _mm256_mul_ps(u, vdt)));
+        _mm256_storeu_ps(py + i, _mm256_add_ps(y, _mm256_mul_ps(v, vdt)));
+        _mm256_storeu_ps(vx + i, _mm256_mul_ps(u, vdamp));
+        _mm256_storeu_ps(vy + i, _mm256_mul_ps(v, vdamp));
+        _mm256_storeu_ps(life + i, _mm256_sub_ps(_mm256_loadu_ps(life + i), vdt));
+    }
+#elif PARTICLES_SSE
+    __m128 vdt = _mm_set1_ps(dt), vdamp = _mm_set1_ps(damp);
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(px + i), y = _mm_loadu_ps(py + i);
+        __m128 u = _mm_loadu_ps(vx + i), v = _mm_loadu_ps(vy + i);
+        _mm_storeu_ps(px + i, _mm_add_ps(x, _mm_mul_ps(u, vdt)));
+        _mm_storeu_ps(py + i, _mm_add_ps(y, _mm_mul_ps(v, vdt)));
+        _mm_storeu_ps(vx + i, _mm_mul_ps(u, vdamp));
+        _mm_storeu_ps(vy + i, _mm_mul_ps(v, vdamp));
+        _mm_storeu_ps(life + i, _mm_sub_ps(_mm_loadu_ps(life + i), vdt));
+    }
+#endif
+    for (; i < n; ++i) {
+        px[i] += vx[i] * dt;
+        py[i] += vy[i] * dt;
+        vx[i] *= damp;
+        vy[i] *= damp;
+        life[i] -= dt;
+    }
+}
+
+void ParticleSystem::update(float dt, JobSystem* jobs) {
+    PROFILE_SCOPE("particles");
+    if (!count) return;
+    float damp = std::pow(Drag, dt);
+    float* px = PosX.data();
+    float* py = PosY.data();
+    float* vx = VelX.data();
+    float* vy = VelY.data();
+    float* life = Life.data();
+    float* inv = InvSpan.data();
+    float* size = Size.data();
+    uint32_t* color = Color.data();
+    uint32_t* alive = chunkAlive.data();
+
+    // one job per chunk, so the chunks line up with chunkAlive however
+    // the job system splits the range
+    size_t n = count;
+    size_t chunks = (n + UPDATE_GRAIN - 1) / UPDATE_GRAIN;
+    parallelFor(jobs, chunks, 1, [=](size_t firstChunk, size_t lastChunk) {
+        for (size_t c = firstChunk; c < lastChunk; ++c) {
+            size_t begin = c * UPDATE_GRAIN;
+            size_t end = begin + UPDATE_GRAIN < n ? begin + UPDATE_GRAIN : n;
+            integrate(px + begin, py + begin, vx + begin, vy + begin, life + begin, end - begin, dt, damp);
+            // pack this chunk's survivors at its front, keeping their order
+            size_t w = begin;
+            for (size_t i = begin; i < end; ++i) {
+                if (life[i] <= 0.f) continue;
+                if (w != i) {
+                    px[w] = px[i]; py[w] = py[i];
+                    vx[w] = vx[i]; vy[w] = vy[i];
+                    life[w] = life[i]; inv[w] = inv[i];
+                    size[w] = size[i]; color[w] = color[i];
+                }
+                w++;
+            }
+            alive[c] = (uint32_t)(w - begin);
+        }
+    });
+
+    // close the gaps between chunks
+    size_t dst = 0;
+    for (size_t c = 0; c < chunks; ++c) {
+        size_t begin = c * UPDATE_GRAIN;
+        size_t kept = alive[c];
+        if (kept && dst != begin) {
+            for (float* a : { px, py, vx, vy, life, inv, size })
+                memmove(a + dst, a + begin, kept * sizeof(float));
+            memmove(color + dst, color + begin, kept * sizeof(uint32_t));
+        }
+        dst += kept;
+    }
+    count = dst;
+}
+
+void ParticleSystem::writeInstances(ParticleInstance* out, JobSystem* jobs) const {
+    PROFILE_SCOPE("particleInstances");
+    const float* px = PosX.data();
+    const float* py = PosY.data();
+    const float* life = Life.data();
+    const float* inv = InvSpan.data();
+    const float* size = Size.data();
+    const uint32_t* color = Color.data();
+    parallelFor(jobs, count, UPDATE_GRAIN, [=](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            float fade = life[i] * inv[i];
+            uint32_t a = (uint32_t)((color[i] >> 24) * (fade < 1.f ? fade : 1.f));
+            out[i] = ParticleInstance{ px[i], py[i], size[i], (color[i] & 0x00ffffffu) | (a << 24) };
+        }
+    });
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Simulation.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// One particle as the renderer takes it, 16 bytes.
+struct ParticleInstance {
+    float    X, Y;
+    float    Size;
+    uint32_t Color;   // RGBA8 (R in the low byte), alpha faded by remaining life
+};
+
+// What one emit() call throws out: Count particles leaving in directions
+// within Spread radians around Angle, on top of Velocity.
+struct ParticleBurst {
+    int       Count = 100;
+    float     SpeedMin = 50.f, SpeedMax = 300.f;
+    float     LifeMin = 0.3f, LifeMax = 1.f;
+    float     SizeMin = 2.f, SizeMax = 5.f;
+    uint32_t  Color = 0xffffffffu;
+    float     Angle = 0.f;
+    float     Spread = 6.2831853f;
+    glm::vec2 Velocity = glm::vec2(0.f);
+};
+
+// Purely visual particles (explosions, trails, sparks); nothing in here
+// feeds back into the game. Storage is one array per component with live
+// particles packed at the front, so update() streams straight through
+// memory: chunks of UPDATE_GRAIN run as jobs, each integrating 8 (AVX) or
+// 4 (SSE) particles per instruction with a scalar tail, then compacting
+// away the dead ones inside the chunk. The chunks are closed up serially
+// with one memmove per component. Capacity is fixed up front; emitting
+// into a full system drops the excess.
+class ParticleSystem {
+public:
+    static const size_t UPDATE_GRAIN = 16384;
+
+    explicit ParticleSystem(size_t capacity = 1 << 20, uint64_t seed = 1);
+    void setCapacity(size_t capacity);
+    void clear() { count = 0; }
+
+    void emit(glm::vec2 pos, const ParticleBurst& burst);
+    // integrate, slow down by `drag` per second and age by `dt`; drop the
+    // particles whose life ran out. `jobs` may be null.
+    void update(float dt, JobSystem* jobs);
+    // size() instances into `out`, in parallel chunks
+    void writeInstances(ParticleInstance* out, JobSystem* jobs) const;
+
+    size_t size() const { return count; }
+    size_t capacity() const { return PosX.size(); }
+    uint64_t dropped() const { return lost; }
+
+    float Drag = 0.9f;   // fraction of speed kept after one second
+
+    std::vector<float>    PosX, PosY, VelX, VelY;
+    std::vector<float>    Life;       // seconds left
+    std::vector<float>    InvSpan;    // 1 / the life it started with
+    std::vector<float>    Size;
+    std::vector<uint32_t> Color;
+
+private:
+    size_t   count = 0;
+    uint64_t lost = 0;
+    Rng      rng;
+    std::vector<uint32_t> chunkAlive;   // survivors per chunk during update()
+};
@@ -0,0 +1,173 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+
+Profiler gProfiler;
+
+struct OpenZone {
+    const char* Name;
+    double      StartUs;
+};
+// zones opened on this thread and not closed yet, and its trace track
+static thread_local std::vector<OpenZone> openZones;
+static thread_local int threadTid = 0;
+
+// weight of the newest frame in the running averages
+static const double AVG_WEIGHT = 0.05;
+
+Profiler::Profiler() : epoch(std::chrono::steady_clock::now()), mainThread(std::this_thread::get_id()) {
+    zoneStats.reserve(32);
+    counterStats.reserve(16);
+}
+
+double Profiler::nowUs() const {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+Profiler::ZoneStat& Profiler::statFor(const char* name, int depth) {
+    for (ZoneStat& z : zoneStats)
+        if (z.Name == name) return z;
+    zoneStats.push_back(ZoneStat{ name, depth, 0.0, 0.0 });
+    return zoneStats.back();
+}
+
+void Profiler::beginFrame() {
+    frameStartUs = nowUs();
+}
+
+void Profiler::endFrame() {
+    double endUs = nowUs();
+    double ms = (endUs - frameStartUs) / 1000.0;
+    lastMs = ms;
+    avgFrameMs = avgFrameMs == 0 ? ms : avgFrameMs + (ms - avgFrameMs) * AVG_WEIGHT;
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (captureFramesLeft > 0) {
+        captured.push_back(TraceEvent{ "frame", 'X', 1, frameStartUs, endUs - frameStartUs });
+        for (const CounterStat& c : counterStats)
+            captured.push_back(TraceEvent{ c.Name, 'C', 1, frameStartUs, c.Value });
+        if (--captureFramesLeft == 0) writeCapture();
+    }
+}
+
+void Profiler::beginZone(const char* name) {
+    if (openZones.capacity() == 0) openZones.reserve(16);
+    openZones.push_back(OpenZone{ name, nowUs() });
+}
+
+void Profiler::endZone() {
+    double endUs = nowUs();
+    OpenZone z = openZones.back();
+    openZones.pop_back();
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (!threadTid) threadTid = std::this_thread::get_id() == mainThread ? 1 : 3 + otherThreads++;
+
+    ZoneStat& s = statFor(z.Name, (int)openZones.size());
+    double ms = (endUs - z.StartUs) / 1000.0;
+    s.CpuMs = s.CpuMs == 0 ? ms : s.CpuMs + (ms - s.CpuMs) * AVG_WEIGHT;
+
+    if (captureFramesLeft > 0)
+        captured.push_back(TraceEvent{ z.Name, 'X', threadTid, z.StartUs, endUs - z.StartUs });
+}
+
+void Profiler::copyZones(std::vector<ZoneStat>& out) const {
+    std::lock_guard<std::mutex> guard(lock);
+    out.assign(zoneStats.begin(), zoneStats.end());
+}
+
+void Profiler::addGpuTime(const char* name, double startUs, double ms) {
+    std::lock_guard<std::mutex> guard(lock);
+    ZoneStat& s = statFor(name, 1);
+    s.GpuMs = s.GpuMs == 0 ? ms : s.GpuMs + (ms - s.GpuMs) * AVG_WEIGHT;
+
+    if (captureFramesLeft > 0)
+        captured.push_back(TraceEvent{ name, 'X', 2, startUs, ms * 1000.0 });
+}
+
+void Profiler::setCounter(const char* name, double value) {
+    for (CounterStat& c : counterStats) {
+        if (c.Name == name) { c.Value = value; return; }
+    }
+    counterStats.push_back(CounterStat{ name, value });
+}
+
+void Profiler::startCapture(int frames, const char* path) {
+    if (capturing()) return;
+    std::lock_guard<std::mutex> guard(lock);
+    capturePath = path;
+    captured.clear();
+    // room for a busy frame, so recording does not allocate mid-capture
+    captured.reserve((size_t)frames * 64);
+    captureFramesLeft = frames;
+}
+
+void Profiler::writeCapture() {
+    FILE* f = fopen(capturePath.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "Profiler: cannot write %s\n", capturePath.c_str());
+        return;
+    }
+    fprintf(f, "{\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n");
+    fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+    for (int t = 3; t < 3 + otherThreads; ++t)
+        fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}", t, t - 2);
+    for (const TraceEvent& e : captured) {
+        if (e.Phase == 'X')
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                e.Name, e.Tid, e.TsUs, e.DurUs);
+        else
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"value\":%.0f}}",
+                e.Name, e.TsUs, e.DurUs);
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    printf("Profiler: wrote %zu events to %s\n", captured.size(), capturePath.c_str());
+}
+
+static const double HIST_BUCKET_MS = 0.25;
+static const int    HIST_BUCKETS = 400;
+
+FrameHistogram::FrameHistogram() : buckets(HIST_BUCKETS, 0) {}
+
+void FrameHistogram::add(double ms) {
+    int b = (int)(ms / HIST_BUCKET_MS);
+    buckets[b < HIST_BUCKETS ? b : HIST_BUCKETS - 1]++;
+    count++;
+    sumMs += ms;
+    if (ms > maxMs) maxMs = ms;
+}
+
+void FrameHistogram::clear() {
+    std::fill(buckets.begin(), buckets.end(), 0u);
+    count = 0;
+    sumMs = maxMs = 0;
+}
+
+double FrameHistogram::percentile(double p) const {
+    uint64_t target = (uint64_t)(p * count), seen = 0;
+    for (int b = 0; b < HIST_BUCKETS; ++b) {
+        seen += buckets[b];
+        if (seen > target) return (b + 1) * HIST_BUCKET_MS;
+    }
+    return maxMs;
+}
+
+void FrameHistogram::print(FILE* out) const {
+    if (!count) return;
+    fprintf(out, "frames %llu  mean %.2f ms  p50 %.2f  p90 %.2f  p99 %.2f  max %.2f ms\n",
+        (unsigned long long)count, sumMs / count,
+        percentile(0.5), percentile(0.9), percentile(0.99), maxMs);
+}
+
+bool FrameHistogram::writeCsv(const char* path) const {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "ms,frames\n");
+    for (int b = 0; b < HIST_BUCKETS; ++b)
+        if (buckets[b]) fprintf(f, "%.2f,%u\n", (b + 1) * HIST_BUCKET_MS, buckets[b]);
+    fclose(f);
+    return true;
+}
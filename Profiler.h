@@ -0,0 +1,118 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Frame profiler: nested CPU zones, GPU durations fed in by the renderer,
+// and per-frame counters. Keeps a running average per zone for the overlay
+// and can capture a number of frames to a Chrome trace_event JSON file
+// (open it in chrome://tracing or ui.perfetto.dev).
+//
+// Zone and counter names must be string literals: they are stored and
+// compared by pointer.
+//
+// Zones may be opened on any thread (the simulation runs on job workers);
+// each thread nests its own zones and shows up as its own track in a
+// capture. Frames, counters and GPU times belong to the main thread.
+class Profiler {
+public:
+    struct ZoneStat {
+        const char* Name;
+        int         Depth;
+        double      CpuMs;   // averaged
+        double      GpuMs;   // averaged, 0 when the zone has no GPU timer
+    };
+    struct CounterStat {
+        const char* Name;
+        double      Value;   // last frame
+    };
+
+    Profiler();
+
+    void beginFrame();
+    void endFrame();
+
+    void beginZone(const char* name);
+    void endZone();
+
+    // a GPU duration measured for `name`; startUs is when the CPU issued
+    // the work, in nowUs() time, and is only used to place it in a capture
+    void addGpuTime(const char* name, double startUs, double ms);
+    void setCounter(const char* name, double value);
+
+    // record the next `frames` frames and write them to `path` afterwards
+    void startCapture(int frames, const char* path);
+    bool capturing() const { return captureFramesLeft > 0; }
+
+    double nowUs() const;
+    double frameMs() const { return avgFrameMs; }
+    double lastFrameMs() const { return lastMs; }
+    // copy of the zone stats; `out` keeps its capacity between calls
+    void copyZones(std::vector<ZoneStat>& out) const;
+    const std::vector<CounterStat>& counters() const { return counterStats; }
+
+private:
+    struct TraceEvent {
+        const char* Name;
+        char        Phase;   // 'X' complete, 'C' counter
+        int         Tid;     // 1 = main thread, 2 = GPU, 3+ = other threads
+        double      TsUs;
+        double      DurUs;   // the value, for counters
+    };
+
+    ZoneStat& statFor(const char* name, int depth);
+    void writeCapture();
+
+    std::chrono::steady_clock::time_point epoch;
+    double frameStartUs = 0, avgFrameMs = 0, lastMs = 0;
+    mutable std::mutex       lock;   // zoneStats and captured
+    std::vector<ZoneStat>    zoneStats;
+    std::thread::id          mainThread;   // the one that constructed us
+    int                      otherThreads = 0;
+    std::vector<CounterStat> counterStats;
+
+    int captureFramesLeft = 0;
+    std::string capturePath;
+    std::vector<TraceEvent> captured;
+};
+
+extern Profiler gProfiler;
+
+struct ProfileScope {
+    explicit ProfileScope(const char* name, bool on = true) : on(on) { if (on) gProfiler.beginZone(name); }
+    ~ProfileScope() { if (on) gProfiler.endZone(); }
+    bool on;
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+// times the rest of the enclosing block as a zone called `name`
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+// the same, only when `on`; for code that also runs outside the game's frames
+#define PROFILE_SCOPE_IF(name, on) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name, on)
+
+// Frame-time histogram in 0.25 ms buckets up to 100 ms (slower frames land
+// in the last bucket). Used to compare replay runs between builds.
+class FrameHistogram {
+public:
+    FrameHistogram();
+    void add(double ms);
+    void clear();
+    uint64_t frames() const { return count; }
+    double maxFrameMs() const { return maxMs; }
+    // frame time at or below which `p` (0..1) of the frames fall
+    double percentile(double p) const;
+    void print(FILE* out) const;
+    // bucket upper bound in ms, frame count
+    bool writeCsv(const char* path) const;
+
+private:
+    std::vector<uint32_t> buckets;
+    uint64_t count = 0;
+    double   sumMs = 0, maxMs = 0;
+};
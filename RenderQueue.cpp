@@ -0,0 +1,135 @@
+#include "RenderQueue.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+void GLStateCache::useProgram(GLuint p) {
+    if (p == program) { stats.Skipped++; return; }
+    glUseProgram(p);
+    program = p;
+    stats.Issued++;
+}
+
+void GLStateCache::bindVertexArray(GLuint v) {
+    if (v == vao) { stats.Skipped++; return; }
+    glBindVertexArray(v);
+    vao = v;
+    stats.Issued++;
+}
+
+void GLStateCache::bindTexture(GLuint t) {
+    if (t == texture) { stats.Skipped++; return; }
+    glBindTexture(GL_TEXTURE_2D, t);
+    texture = t;
+    stats.Issued++;
+}
+
+void GLStateCache::blend(BlendMode mode) {
+    if ((int)mode == blendMode) { stats.Skipped++; return; }
+    glBlendFunc(GL_SRC_ALPHA, mode == BLEND_ADD ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+    blendMode = mode;
+    stats.Issued++;
+}
+
+void GLStateCache::invalidate() {
+    program = vao = texture = UNKNOWN;
+    blendMode = -1;
+}
+
+GLStateCache::Stats GLStateCache::takeStats() {
+    Stats s = stats;
+    stats = Stats();
+    return s;
+}
+
+bool RenderQueue::init(size_t maxCommands) {
+    destroy();
+    capacity = maxCommands;
+    commands.reserve(capacity);
+    keys.reserve(capacity);
+    glGenBuffers(1, &frameUbo);
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUbo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, frameUbo);
+    return frameUbo != 0;
+}
+
+void RenderQueue::destroy() {
+    if (frameUbo) glDeleteBuffers(1, &frameUbo);
+    frameUbo = 0;
+    programs.clear();
+    commands.clear();
+    keys.clear();
+}
+
+ProgramId RenderQueue::addProgram(GLuint id) {
+    ProgramInfo info;
+    info.Id = id;
+    GLint count = 0;
+    glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        char name[64];
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(id, (GLuint)i, sizeof(name), &length, &size, &type, name);
+        // block members have no location and are skipped
+        GLint loc = glGetUniformLocation(id, name);
+        if (loc >= 0) info.Uniforms.emplace_back(name, loc);
+    }
+    GLuint block = glGetUniformBlockIndex(id, "Frame");
+    if (block != GL_INVALID_INDEX) glUniformBlockBinding(id, block, FRAME_BLOCK_BINDING);
+    programs.push_back(std::move(info));
+    return (ProgramId)(programs.size() - 1);
+}
+
+GLint RenderQueue::uniform(ProgramId id, const char* name) const {
+    for (const auto& u : programs[id].Uniforms)
+        if (u.first == name) return u.second;
+    return -1;
+}
+
+void RenderQueue::beginFrame(const glm::mat4& projection) {
+    // render targets, captures and loaders bind things behind our back
+    // between frames; start from nothing known
+    cache.invalidate();
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUbo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(projection));
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    droppedCommands = 0;
+}
+
+bool RenderQueue::push(const DrawCommand& command) {
+    if (commands.size() == capacity) {
+        droppedCommands++;
+        return false;
+    }
+    commands.push_back(command);
+    return true;
+}
+
+void RenderQueue::submit() {
+    keys.clear();
+    for (size_t i = 0; i < commands.size(); ++i) {
+        const DrawCommand& c = commands[i];
+        keys.push_back((uint64_t)c.Layer << 56 | (uint64_t)c.Program << 48 |
+            (uint64_t)(c.Texture & 0xffff) << 32 | (uint64_t)i);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    for (uint64_t key : keys) {
+        const DrawCommand& c = commands[(uint32_t)key];
+        cache.useProgram(programs[c.Program].Id);
+        cache.bindVertexArray(c.Vao);
+        if (c.Texture) cache.bindTexture(c.Texture);
+        cache.blend(c.Blend);
+        if (c.Attribs) c.Attribs(c.StreamOffset);
+        if (c.FloatUniform >= 0) glUniform1f(c.FloatUniform, c.FloatValue);
+        if (c.Instances) glDrawArraysInstanced(c.Primitive, 0, c.Count, c.Instances);
+        else glDrawArrays(c.Primitive, 0, c.Count);
+    }
+    commands.clear();
+}
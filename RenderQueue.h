@@ -0,0 +1,104 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum BlendMode : uint8_t { BLEND_ALPHA, BLEND_ADD };
+
+// The last program, VAO, unit 0 texture and blend mode handed to GL, so
+// asking for what is already bound never reaches the driver. Code that
+// binds these directly must invalidate() before the next cached call.
+class GLStateCache {
+public:
+    struct Stats {
+        uint32_t Issued = 0;    // calls that reached GL
+        uint32_t Skipped = 0;   // redundant calls dropped
+    };
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vao);
+    void bindTexture(GLuint texture);
+    void blend(BlendMode mode);
+    void invalidate();
+
+    Stats takeStats();
+
+private:
+    static const GLuint UNKNOWN = ~0u;
+    GLuint program = UNKNOWN;
+    GLuint vao = UNKNOWN;
+    GLuint texture = UNKNOWN;
+    int    blendMode = -1;
+    Stats  stats;
+};
+
+typedef uint8_t ProgramId;
+
+// One draw, recorded now and issued at submit(). Everything it needs is
+// in the command: streamed attributes are pointed at StreamOffset by
+// Attribs once the VAO is bound.
+struct DrawCommand {
+    uint8_t   Layer = 0;           // drawn in increasing order
+    ProgramId Program = 0;
+    GLuint    Vao = 0;
+    GLuint    Texture = 0;         // unit 0; 0 leaves it alone
+    BlendMode Blend = BLEND_ALPHA;
+    GLenum    Primitive = GL_TRIANGLES;
+    GLsizei   Count = 0;           // vertices
+    GLsizei   Instances = 0;       // 0 for a plain glDrawArrays
+    void    (*Attribs)(size_t offset) = nullptr;
+    size_t    StreamOffset = 0;
+    GLint     FloatUniform = -1;   // one optional float, e.g. the starfield time
+    float     FloatValue = 0.f;
+};
+
+// Draws recorded over a frame and issued in one go, sorted by (layer,
+// program, texture) with recording order kept among equals, through a
+// GLStateCache. Programs are registered once after linking: their
+// uniform locations are looked up there, and their `Frame` uniform block
+// (the projection) is tied to one UBO written once per frame.
+class RenderQueue {
+public:
+    static const GLuint FRAME_BLOCK_BINDING = 0;
+
+    RenderQueue() = default;
+    ~RenderQueue() { destroy(); }
+    RenderQueue(const RenderQueue&) = delete;
+    RenderQueue& operator=(const RenderQueue&) = delete;
+
+    // `maxCommands` per frame; more are dropped
+    bool init(size_t maxCommands);
+    void destroy();
+
+    ProgramId addProgram(GLuint program);
+    GLuint program(ProgramId id) const { return programs[id].Id; }
+    // location cached at addProgram, -1 when the program has no such uniform
+    GLint uniform(ProgramId id, const char* name) const;
+
+    void beginFrame(const glm::mat4& projection);
+    bool push(const DrawCommand& command);
+    void submit();
+
+    GLStateCache& state() { return cache; }
+    uint32_t dropped() const { return droppedCommands; }
+
+private:
+    struct ProgramInfo {
+        GLuint Id = 0;
+        std::vector<std::pair<std::string, GLint>> Uniforms;
+    };
+
+    std::vector<ProgramInfo> programs;
+    std::vector<DrawCommand> commands;
+    std::vector<uint64_t> keys;         // sort key, command index in the low bits
+    size_t capacity = 0;
+    GLuint frameUbo = 0;
+    GLStateCache cache;
+    uint32_t droppedCommands = 0;
+};
@@ -0,0 +1,41 @@
+#include "RenderTarget.h"
+
+#include <cstdio>
+
+bool RenderTarget::create(int width, int height) {
+    destroy();
+    w = width;
+    h = height;
+    glGenFramebuffers(1, &fbo);
+    glGenRenderbuffers(1, &color);
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    bool ok = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    if (!ok) {
+        fprintf(stderr, "RenderTarget: %dx%d framebuffer incomplete\n", w, h);
+        destroy();
+    }
+    return ok;
+}
+
+void RenderTarget::destroy() {
+    if (fbo) glDeleteFramebuffers(1, &fbo);
+    if (color) glDeleteRenderbuffers(1, &color);
+    fbo = color = 0;
+}
+
+void RenderTarget::bind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, w, h);
+}
+
+void RenderTarget::blit(GLuint dstFbo, int srcW, int srcH, int dstX0, int dstY0, int dstX1, int dstY1) const {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dstFbo);
+    bool sameSize = dstX1 - dstX0 == srcW && dstY1 - dstY0 == srcH;
+    glBlitFramebuffer(0, 0, srcW, srcH, dstX0, dstY0, dstX1, dstY1, GL_COLOR_BUFFER_BIT,
+        sameSize ? GL_NEAREST : GL_LINEAR);
+}
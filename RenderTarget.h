@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Framebuffer object with one RGBA8 color renderbuffer. A frame may draw
+// into only part of it (see DynamicResolution) and blit that part out.
+class RenderTarget {
+public:
+    RenderTarget() = default;
+    ~RenderTarget() { destroy(); }
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+
+    bool create(int width, int height);
+    void destroy();
+    // bind for drawing with the viewport over the whole target
+    void bind() const;
+    // scale the lower-left srcW x srcH pixels into a rect of `dstFbo`
+    void blit(GLuint dstFbo, int srcW, int srcH, int dstX0, int dstY0, int dstX1, int dstY1) const;
+
+    GLuint framebuffer() const { return fbo; }
+    int width() const { return w; }
+    int height() const { return h; }
+
+private:
+    GLuint fbo = 0, color = 0;
+    int w = 0, h = 0;
+};
@@ -0,0 +1,111 @@
+#include "Replay.h"
+
+#include <cstring>
+
+static const char MAGIC[4] = { 'Z', 'V', 'R', 'P' };
+static const uint16_t VERSION = 2;
+static const long END_TICK_OFFSET = 4 + 2 + 2 + 8;
+
+static void putLE(FILE* f, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) fputc((int)((v >> (8 * i)) & 0xff), f);
+}
+
+static bool getLE(FILE* f, uint64_t& v, int bytes) {
+    v = 0;
+    for (int i = 0; i < bytes; ++i) {
+        int c = fgetc(f);
+        if (c == EOF) return false;
+        v |= (uint64_t)c << (8 * i);
+    }
+    return true;
+}
+
+static bool getVarint(FILE* f, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = fgetc(f);
+        if (c == EOF) return false;
+        v |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80)) return true;
+    }
+    return false;
+}
+
+bool ReplayWriter::open(const char* path, uint64_t seed, unsigned int tickRate) {
+    file = fopen(path, "wb");
+    if (!file) return false;
+    this->path = path;
+    fwrite(MAGIC, 1, 4, file);
+    putLE(file, VERSION, 2);
+    putLE(file, tickRate, 2);
+    putLE(file, seed, 8);
+    putLE(file, 0, 8);   // end tick, patched by close()
+    lastTick = 0;
+    return true;
+}
+
+void ReplayWriter::putVarint(uint64_t v) {
+    while (v >= 0x80) {
+        fputc((int)(v & 0x7f) | 0x80, file);
+        v >>= 7;
+    }
+    fputc((int)v, file);
+}
+
+void ReplayWriter::write(const KeyEvent& e) {
+    if (!file) return;
+    putVarint(e.Tick - lastTick);
+    putVarint((uint64_t)e.Key);
+    fputc(e.Action, file);
+    fputc(e.SubTick, file);
+    lastTick = e.Tick;
+}
+
+void ReplayWriter::close(uint64_t endTick) {
+    if (!file) return;
+    fseek(file, END_TICK_OFFSET, SEEK_SET);
+    putLE(file, endTick, 8);
+    fclose(file);
+    file = nullptr;
+}
+
+void ReplayWriter::abandon() {
+    if (!file) return;
+    fclose(file);
+    file = nullptr;
+    remove(path.c_str());
+}
+
+bool ReplayReader::load(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+
+    char magic[4];
+    uint64_t version, rate;
+    bool ok = fread(magic, 1, 4, f) == 4 && memcmp(magic, MAGIC, 4) == 0 &&
+        getLE(f, version, 2) && version >= 1 && version <= VERSION &&
+        getLE(f, rate, 2) && getLE(f, Seed, 8) && getLE(f, EndTick, 8);
+    TickRate = (unsigned int)rate;
+
+    Events.clear();
+    next = 0;
+    uint64_t tick = 0, delta, key;
+    while (ok && getVarint(f, delta)) {
+        int action, subTick = 0;
+        if (!getVarint(f, key) || (action = fgetc(f)) == EOF ||
+            (version >= 2 && (subTick = fgetc(f)) == EOF)) {
+            ok = false;
+            break;
+        }
+        // handleKey indexes its key table with these; actions are
+        // GLFW_RELEASE (0) and GLFW_PRESS (1)
+        if (key >= (uint64_t)KEY_CODE_LIMIT || action > 1) {
+            ok = false;
+            break;
+        }
+        tick += delta;
+        Events.push_back(KeyEvent{ tick, (int)key, action, (uint8_t)subTick });
+    }
+    fclose(f);
+    return ok;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// key codes are GLFW's, all below this
+const int KEY_CODE_LIMIT = 1024;
+
+// A key press or release, stamped with the simulation tick it was applied
+// on and where inside that tick it happened.
+struct KeyEvent {
+    uint64_t Tick;
+    int      Key;
+    int      Action;    // GLFW_PRESS / GLFW_RELEASE
+    uint8_t  SubTick;   // 1/256ths of the tick
+};
+
+// Recording file layout, all little-endian:
+//   "ZVRP"  u16 version  u16 tick rate  u64 seed  u64 end tick
+//   then per event: varint tick delta, varint key, u8 action, u8 sub-tick
+// Version 1 files have no sub-tick byte and load with SubTick 0.
+// The end tick is patched in when the recording is closed; a recording
+// that is never closed has no end and is deleted.
+class ReplayWriter {
+public:
+    ~ReplayWriter() { abandon(); }
+    bool open(const char* path, uint64_t seed, unsigned int tickRate);
+    void write(const KeyEvent& e);
+    // `endTick` is the first tick that is not part of the recording
+    void close(uint64_t endTick);
+    // stop recording and delete the file
+    void abandon();
+    bool isOpen() const { return file != nullptr; }
+
+private:
+    void putVarint(uint64_t v);
+
+    FILE*       file = nullptr;
+    std::string path;
+    uint64_t    lastTick = 0;
+};
+
+class ReplayReader {
+public:
+    // fails on a file that is cut short or holds a key code or action no
+    // recording can contain
+    bool load(const char* path);
+
+    uint64_t Seed = 0;
+    unsigned int TickRate = 0;
+    uint64_t EndTick = 0;
+    std::vector<KeyEvent> Events;
+
+    // events stamped with `tick`, in recorded order; call with increasing ticks
+    template <class F>
+    void replayTick(uint64_t tick, F&& apply) {
+        while (next < Events.size() && Events[next].Tick == tick)
+            apply(Events[next++]);
+    }
+    bool finished(uint64_t tick) const { return tick >= EndTick; }
+
+private:
+    size_t next = 0;
+};
@@ -0,0 +1,124 @@
+#include "SimBatch.h"
+
+#include "JobSystem.h"
+
+#include <algorithm>
+
+static const size_t PLAYER_OBS = 4;
+static const size_t ENEMY_OBS = 4;
+static const size_t BULLET_OBS = 3;
+
+SimBatch::SimBatch(const SimBatchConfig& cfg, JobSystem* jobSystem)
+    : config(cfg), jobs(jobSystem) {
+    // thousands of envs on every worker would serialize on the profiler
+    // and blur into one zone
+    config.Sim.Profiled = false;
+    obsSize = PLAYER_OBS + config.ObservedEnemies * ENEMY_OBS + config.ObservedBullets * BULLET_OBS;
+    games.reserve(config.Envs);
+    for (size_t i = 0; i < config.Envs; ++i)
+        games.emplace_back(config.Seed + i, config.Sim);
+    episodeSteps.assign(config.Envs, 0);
+    nextSeed.assign(config.Envs, 0);
+    obs.assign(config.Envs * obsSize, 0.f);
+    reward.assign(config.Envs, 0.f);
+    done.assign(config.Envs, 0);
+    order.resize(config.Envs);
+    for (std::vector<uint32_t>& o : order)
+        o.reserve(std::max(config.Sim.MaxEnemies, config.Sim.MaxBullets));
+    reset();
+}
+
+void SimBatch::reset() {
+    for (size_t i = 0; i < envs(); ++i) {
+        nextSeed[i] = config.Seed + i;
+        resetEnv(i);
+        reward[i] = 0.f;
+        done[i] = 0;
+        observe(i);
+    }
+}
+
+void SimBatch::resetEnv(size_t env) {
+    games[env].reset(nextSeed[env]);
+    nextSeed[env] += envs();
+    episodeSteps[env] = 0;
+}
+
+void SimBatch::step(const SimInput* actions) {
+    size_t n = envs();
+    // an env step is a few microseconds, so hand out a few dozen at a time
+    size_t grain = std::max<size_t>(1, std::min<size_t>(64, n / 64));
+    auto run = [this, actions](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) stepEnv(i, actions[i]);
+    };
+    if (jobs) jobs->parallelFor(n, grain, run);
+    else run(0, n);
+    stepsTaken += n;
+}
+
+void SimBatch::stepEnv(size_t env, const SimInput& action) {
+    Simulation& g = games[env];
+    unsigned int scoreBefore = g.Score;
+    SimInput in = action;
+    for (int t = 0; t < config.TicksPerStep && g.Player.Health > 0; ++t) {
+        g.step(in, true);
+        in.FireAt = 0.f;
+    }
+    reward[env] = (float)(g.Score - scoreBefore);
+    episodeSteps[env]++;
+    bool over = g.Player.Health <= 0 || (config.MaxSteps && episodeSteps[env] >= config.MaxSteps);
+    done[env] = over;
+    if (over) resetEnv(env);
+    observe(env);
+}
+
+void SimBatch::observe(size_t env) {
+    const Simulation& g = games[env];
+    float* o = obs.data() + env * obsSize;
+    const float sx = 1.f / WORLD_WIDTH, sy = 1.f / WORLD_HEIGHT;
+
+    *o++ = g.Player.Position.y * sy;
+    *o++ = g.Player.Health / 100.f;
+    *o++ = g.Score / 1000.f;
+    *o++ = (double)(g.Tick + 1) * SIM_DT > g.nextShotTime() ? 1.f : 0.f;
+
+    // the enemies closest to the left edge are the ones about to cost health
+    std::vector<uint32_t>& idx = order[env];
+    const EntityStore& enemies = g.Enemies;
+    size_t shown = std::min(config.ObservedEnemies, enemies.size());
+    idx.resize(enemies.size());
+    for (size_t i = 0; i < idx.size(); ++i) idx[i] = (uint32_t)i;
+    std::partial_sort(idx.begin(), idx.begin() + shown, idx.end(), [&](uint32_t a, uint32_t b) {
+        return enemies.Position[a].x < enemies.Position[b].x;
+    });
+    for (size_t k = 0; k < config.ObservedEnemies; ++k, o += ENEMY_OBS) {
+        if (k >= shown) {
+            o[0] = o[1] = o[2] = o[3] = 0.f;
+            continue;
+        }
+        uint32_t i = idx[k];
+        o[0] = enemies.Position[i].x * sx;
+        o[1] = enemies.Position[i].y * sy;
+        o[2] = enemies.Velocity[i].x / 250.f;
+        o[3] = 1.f;
+    }
+
+    // the newest bullets, nearest the player, have the most left to hit
+    const EntityStore& bullets = g.Bullets;
+    shown = std::min(config.ObservedBullets, bullets.size());
+    idx.resize(bullets.size());
+    for (size_t i = 0; i < idx.size(); ++i) idx[i] = (uint32_t)i;
+    std::partial_sort(idx.begin(), idx.begin() + shown, idx.end(), [&](uint32_t a, uint32_t b) {
+        return bullets.Position[a].x < bullets.Position[b].x;
+    });
+    for (size_t k = 0; k < config.ObservedBullets; ++k, o += BULLET_OBS) {
+        if (k >= shown) {
+            o[0] = o[1] = o[2] = 0.f;
+            continue;
+        }
+        uint32_t i = idx[k];
+        o[0] = bullets.Position[i].x * sx;
+        o[1] = bullets.Position[i].y * sy;
+        o[2] = 1.f;
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Simulation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+struct SimBatchConfig {
+    size_t    Envs = 64;
+    uint64_t  Seed = 1;          // env i starts from Seed + i, each reset moves on by Envs
+    int       TicksPerStep = 4;  // an action is held for this many ticks (30 steps per game second)
+    uint64_t  MaxSteps = 0;      // steps before an episode is cut off, 0 = until the player dies
+    size_t    ObservedEnemies = 8;
+    size_t    ObservedBullets = 8;
+    SimConfig Sim;
+};
+
+// Many independent games stepped in lock-step for bots and training: no
+// window, clock, GL or audio, just a Simulation per env. step() applies
+// one action per env, runs the envs as jobs and leaves the results in
+// flat arrays owned by the batch, so a caller (or a binding) can read a
+// whole batch without copying. An env whose episode ends is reset
+// straight away; dones() says which ones did, and their observation is
+// already the first of the new episode.
+//
+// Observation layout per env, observationSize() floats, positions
+// divided by the world size:
+//   player y, health / 100, score / 1000, gun ready this tick (0/1),
+//   ObservedEnemies x (x, y, velocity x / 250, present), leftmost first,
+//   ObservedBullets x (x, y, present), leftmost first
+// with absent slots all zero.
+class SimBatch {
+public:
+    SimBatch(const SimBatchConfig& config, JobSystem* jobs = nullptr);
+
+    void reset();
+    // `actions` holds envs() entries; Fire is held for the whole step
+    void step(const SimInput* actions);
+
+    size_t envs() const { return games.size(); }
+    size_t observationSize() const { return obsSize; }
+    const float*   observations() const { return obs.data(); }
+    const float*   rewards() const { return reward.data(); }   // score gained this step
+    const uint8_t* dones() const { return done.data(); }
+    const Simulation& game(size_t env) const { return games[env]; }
+    uint64_t totalSteps() const { return stepsTaken; }
+
+private:
+    void stepEnv(size_t env, const SimInput& action);
+    void resetEnv(size_t env);
+    void observe(size_t env);
+
+    SimBatchConfig config;
+    JobSystem* jobs;
+    std::vector<Simulation> games;
+    std::vector<uint64_t> episodeSteps;
+    std::vector<uint64_t> nextSeed;
+    size_t obsSize;
+    std::vector<float>   obs;
+    std::vector<float>   reward;
+    std::vector<uint8_t> done;
+    std::vector<std::vector<uint32_t>> order;   // per-env sort scratch
+    uint64_t stepsTaken = 0;
+};
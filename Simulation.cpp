@@ -0,0 +1,229 @@
+#include "Simulation.h"
+
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+// entities per job; below this a loop is not worth splitting
+static const size_t INTEGRATE_GRAIN = 4096;
+static const size_t COLLIDE_GRAIN = 512;
+
+template <class F>
+static void parallelFor(JobSystem* jobs, size_t count, size_t grain, const F& f) {
+    if (jobs) jobs->parallelFor(count, grain, f);
+    else if (count) f((size_t)0, count);
+}
+
+void Rng::reseed(uint64_t seed) {
+    state = 0;
+    next();
+    state += seed;
+    next();
+}
+
+uint32_t Rng::next() {
+    uint64_t old = state;
+    state = old * 6364136223846793005ull + 1442695040888963407ull;
+    uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+    uint32_t rot = (uint32_t)(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+}
+
+Simulation::Simulation(uint64_t seed, const SimConfig& cfg)
+    : Seed(seed), rng(seed), config(cfg),
+      // broad phase cells are one enemy wide so a box overlaps at most 2x2 cells
+      bulletGrid(WORLD_WIDTH, WORLD_HEIGHT, ENEMY_SIZE) {
+    Player.Size = glm::vec2(80, 80);
+    Player.Color = glm::vec3(0.2f, 0.6f, 1.f);
+    Partner.Size = Player.Size;
+    Partner.Color = glm::vec3(1.f, 0.6f, 0.2f);
+    Partner.Health = 0.f;
+
+    // every container a tick touches is sized here, so step() never allocates
+    Bullets.setCapacity(config.MaxBullets);
+    Enemies.setCapacity(config.MaxEnemies);
+    bulletGrid.reserve(config.MaxBullets);
+    deadEnemies.reserve(config.MaxEnemies);
+    Kills.reserve(config.MaxEnemies);
+    enemyHits.reserve(config.MaxEnemies);
+    waves.init(config.Waves);
+
+    reset(seed);
+}
+
+void Simulation::reset(uint64_t seed) {
+    Seed = seed;
+    rng.reseed(seed);
+    Tick = 0;
+    spawnTimer = 0.f;
+    nextShot = SHOT_INTERVAL;
+    partnerNextShot = SHOT_INTERVAL;
+    ShotsFired = 0;
+    ShotsMissed = 0;
+    Kills.clear();
+    // player on the left
+    Player.Position = glm::vec2(20, WORLD_HEIGHT / 2 - 25);
+    PrevPlayerPosition = Player.Position;
+    // co-op partner below it
+    Partner.Position = Player.Position - glm::vec2(0, 160);
+    PrevPartnerPosition = Partner.Position;
+    resetRound();
+}
+
+void Simulation::resetRound() {
+    Score = 0;
+    Player.Health = 100;
+    Enemies.clear();
+    Bullets.clear();
+    waves.reset();
+}
+
+// spawn an enemy on the right, random Y
+void Simulation::spawnEnemy() {
+    glm::vec2 size(ENEMY_SIZE, ENEMY_SIZE);
+    glm::vec2 pos(WORLD_WIDTH, (float)rng.below((uint32_t)(WORLD_HEIGHT - size.y)));
+    // negative ? moves left
+    float speed = -(150.f + rng.below(100));
+    Enemies.create(pos, glm::vec2(speed, 0.f), size, rng.below(config.EnemyTextures));
+}
+
+void Simulation::step(const SimInput& in, bool spawning, const SimInput* partner, size_t partnerCount) {
+    ShotsFired = 0;
+    ShotsMissed = 0;
+    Kills.clear();
+
+    PrevPlayerPosition = Player.Position;
+    PrevPartnerPosition = Partner.Position;
+    Bullets.savePositions();
+    Enemies.savePositions();
+
+    updatePlayer(in);
+    if (config.Coop) updatePartner(partner, partnerCount);
+    updateSpawning(spawning);
+    updateBullets();
+    updateEnemies();
+    resolveCollisions();
+
+    Tick++;
+}
+
+void Simulation::steer(Entity& ship, const SimInput& in) {
+    // only vertical movement
+    float v = 600.f * SIM_DT;
+    if (in.Up && ship.Position.y + ship.Size.y < WORLD_HEIGHT)
+        ship.Position.y += v;
+    if (in.Down && ship.Position.y > 0)
+        ship.Position.y -= v;
+}
+
+void Simulation::updatePlayer(const SimInput& in) {
+    steer(Player, in);
+    fire(Player, nextShot, in);
+}
+
+void Simulation::updatePartner(const SimInput* inputs, size_t count) {
+    // the gun still fires on this tick's clock, at most once, for the
+    // first input holding the trigger
+    SimInput trigger;
+    for (size_t i = 0; i < count; ++i) {
+        steer(Partner, inputs[i]);
+        if (inputs[i].Fire && !trigger.Fire) trigger = inputs[i];
+    }
+    fire(Partner, partnerNextShot, trigger);
+}
+
+void Simulation::fire(const Entity& ship, double& readyAt, const SimInput& in) {
+    // Shoot at the exact moment the gun is ready or the trigger went
+    // down, which is usually inside the tick. The bullet starts where it
+    // would have been at the tick's start had it been fired then, so after
+    // this tick's integration it has flown exactly since that moment and
+    // the cadence and spacing do not depend on the tick or frame rate.
+    double tickStart = (double)Tick * SIM_DT;
+    double shotAt = std::max(readyAt, tickStart + in.FireAt * (double)SIM_DT);
+    if (in.Fire && shotAt < tickStart + SIM_DT) {
+        glm::vec2 vel(600.f, 0.f);
+        glm::vec2 muzzle = ship.Position + glm::vec2(ship.Size.x, ship.Size.y / 2 - 5);
+        Bullets.create(muzzle - vel * (float)(shotAt - tickStart), vel, glm::vec2(10, 4));
+        readyAt = shotAt + SHOT_INTERVAL;
+        ShotsFired++;
+    }
+}
+
+void Simulation::updateSpawning(bool spawning) {
+    if (waves.enabled()) {
+        if (spawning) waves.update(SIM_DT, Enemies, rng, config.EnemyTextures);
+        return;
+    }
+    spawnTimer += SIM_DT;
+    if (spawning && spawnTimer >= 0.5f) {
+        spawnEnemy();
+        spawnTimer = 0;
+    }
+}
+
+void Simulation::updateBullets() {
+    glm::vec2* pos = Bullets.Position.data();
+    const glm::vec2* vel = Bullets.Velocity.data();
+    parallelFor(jobs, Bullets.size(), INTEGRATE_GRAIN, [=](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            pos[i] += vel[i] * SIM_DT;
+    });
+    for (size_t i = Bullets.size(); i-- > 0; )
+        if (Bullets.Position[i].x > WORLD_WIDTH + 10) {
+            Bullets.removeAt(i);
+            ShotsMissed++;
+        }
+}
+
+void Simulation::updateEnemies() {
+    glm::vec2* pos = Enemies.Position.data();
+    const glm::vec2* vel = Enemies.Velocity.data();
+    parallelFor(jobs, Enemies.size(), INTEGRATE_GRAIN, [=](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            pos[i].x += vel[i].x * SIM_DT;
+    });
+}
+
+// bucket the bullets, then let each enemy (in order) claim the first bullet
+// inside it. Hits are only recorded here and removed afterwards in one pass,
+// so nothing is erased mid-iteration.
+//
+// The grid queries run in parallel and only look for the lowest bullet in
+// each enemy, ignoring claims. The ordered pass then takes that bullet if
+// it is still free and only re-queries when an earlier enemy got it first,
+// which gives exactly the serial result.
+void Simulation::resolveCollisions() {
+    PROFILE_SCOPE_IF("collisions", config.Profiled);
+    bulletGrid.build(Bullets.Position.data(), Bullets.size());
+    deadEnemies.assign(Enemies.size(), 0);
+    enemyHits.resize(Enemies.size());
+
+    const glm::vec2* pos = Enemies.Position.data();
+    const glm::vec2* size = Enemies.Size.data();
+    int32_t* hits = enemyHits.data();
+    const CollisionGrid& grid = bulletGrid;
+    parallelFor(jobs, Enemies.size(), COLLIDE_GRAIN, [=, &grid](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            hits[i] = grid.firstInside(pos[i], size[i]);
+    });
+
+    for (size_t i = 0; i < Enemies.size(); ++i) {
+        // off-screen left
+        if (Enemies.Position[i].x + Enemies.Size[i].x < 0) {
+            Player.Health -= 20.f;
+            deadEnemies[i] = 1;
+        }
+        else if (enemyHits[i] >= 0 && (bulletGrid.tryClaim((size_t)enemyHits[i]) ||
+                 bulletGrid.claim(Enemies.Position[i], Enemies.Size[i]) >= 0)) {
+            Score += 10;
+            deadEnemies[i] = 1;
+            Kills.push_back(Enemies.Position[i] + Enemies.Size[i] * 0.5f);
+        }
+    }
+    // swap-and-pop from the back so indices still to visit stay put
+    for (size_t i = Enemies.size(); i-- > 0; )
+        if (deadEnemies[i]) Enemies.removeAt(i);
+    for (size_t i = Bullets.size(); i-- > 0; )
+        if (bulletGrid.isClaimed(i)) Bullets.removeAt(i);
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "CollisionGrid.h"
+#include "EntityStore.h"
+#include "Waves.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// world size in game units; the renderer maps it 1:1 onto the window
+const float WORLD_WIDTH = 1920.f;
+const float WORLD_HEIGHT = 1080.f;
+
+// enemies are square
+const float ENEMY_SIZE = 100.f;
+
+// the simulation always advances in steps of this length
+const float SIM_TICK_RATE = 120.f;
+const float SIM_DT = 1.f / SIM_TICK_RATE;
+
+// player
+struct Entity {
+    glm::vec2 Position;
+    glm::vec2 Size;
+    glm::vec3 Color;
+    float     Health;
+};
+
+// PCG32: small, fast, and the same sequence on every platform, unlike rand()
+class Rng {
+public:
+    explicit Rng(uint64_t seed = 1) { reseed(seed); }
+    void reseed(uint64_t seed);
+    uint32_t next();
+    // uniform integer in [0, n)
+    uint32_t below(uint32_t n) { return (uint32_t)(((uint64_t)next() * n) >> 32); }
+private:
+    uint64_t state = 0;
+};
+
+// sizes fixed when a Simulation is created
+struct SimConfig {
+    unsigned int EnemyTextures = 3;   // TexID of enemies is drawn from [0, EnemyTextures)
+    // pool sizes; a shot or spawn that does not fit is dropped
+    size_t       MaxBullets = 512;
+    size_t       MaxEnemies = 512;
+    // enemies come in these waves (which must outlive the Simulation);
+    // nullptr keeps the classic single enemy every half second
+    const WaveSet* Waves = nullptr;
+    // a second ship, Partner, flown by step()'s partner inputs
+    bool         Coop = false;
+    // time step()'s phases as gProfiler zones; the zones take the
+    // profiler's lock, so SimBatch turns this off
+    bool         Profiled = true;
+};
+
+// time between shots while fire is held, in seconds
+const double SHOT_INTERVAL = 0.2;
+
+// what the player is holding down during one tick
+struct SimInput {
+    bool Up = false;
+    bool Down = false;
+    bool Fire = false;
+    // how far into the tick (0..1) Fire went down, 0 if it was already held
+    float FireAt = 0.f;
+};
+
+// All gameplay state and the rules that advance it. No GL, GLFW or audio
+// in here, so it can be stepped without a window (benchmarks, replays).
+// Given the same seed and the same inputs per tick it always produces the
+// same game.
+class Simulation {
+public:
+    explicit Simulation(uint64_t seed, const SimConfig& config = SimConfig());
+
+    // a new game with `seed`, the same as a freshly constructed one but
+    // keeping every allocation
+    void reset(uint64_t seed);
+    // back to a fresh round: score, health and entities, not the player's position
+    void resetRound();
+
+    // spread the integration and broad phase of step() over `jobs`
+    // (nullptr = run on the calling thread); results are identical either way
+    void setJobs(JobSystem* jobs) { this->jobs = jobs; }
+
+    // Advance one fixed tick; enemies only spawn while `spawning`. In co-op
+    // the partner's ship takes `partnerCount` inputs, each a whole tick's
+    // move, so a networked partner's inputs are applied exactly once however
+    // bunched up they arrive, and its own prediction of them stays exact.
+    void step(const SimInput& in, bool spawning, const SimInput* partner = nullptr, size_t partnerCount = 0);
+
+    // one tick's vertical move of a ship
+    static void steer(Entity& ship, const SimInput& in);
+
+    // the phases of step(), in the order it runs them; public so the
+    // benchmarks can time them one at a time
+    void updatePlayer(const SimInput& in);
+    void updatePartner(const SimInput* inputs, size_t count);
+    void updateSpawning(bool spawning);
+    void updateBullets();
+    void updateEnemies();
+    void resolveCollisions();
+    void spawnEnemy();
+
+    Entity        Player;    // its Health is the team's in co-op
+    glm::vec2     PrevPlayerPosition;
+    Entity        Partner;   // co-op only
+    glm::vec2     PrevPartnerPosition;
+    EntityStore   Bullets;   // Velocity, Size
+    EntityStore   Enemies;   // Velocity.x is the speed, TexID indexes the enemy sprites
+
+    unsigned int  Score = 0;
+    uint64_t      Tick = 0;
+    uint64_t      Seed;
+
+    // sim time the gun can fire again
+    double nextShotTime() const { return nextShot; }
+    bool coop() const { return config.Coop; }
+    // waves fired this round, 0 without a WaveSet
+    uint32_t wavesFired() const { return waves.wavesFired(); }
+
+    // what happened during the last step()
+    unsigned int  ShotsFired = 0;   // by either ship
+    unsigned int  ShotsMissed = 0;   // bullets that left the screen
+    std::vector<glm::vec2> Kills;   // centres of the enemies shot down
+
+private:
+    void fire(const Entity& ship, double& readyAt, const SimInput& in);
+
+    Rng           rng;
+    SimConfig     config;
+    float         spawnTimer = 0.f;
+    WaveScheduler waves;
+    double        nextShot = SHOT_INTERVAL;   // sim time the gun is ready again
+    double        partnerNextShot = SHOT_INTERVAL;
+    CollisionGrid bulletGrid;
+    std::vector<uint8_t> deadEnemies;
+    std::vector<int32_t> enemyHits;   // first bullet inside each enemy, -1 for none
+    JobSystem*    jobs = nullptr;
+};
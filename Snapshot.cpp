@@ -0,0 +1,409 @@
+#include "Snapshot.h"
+
+#include "Simulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+// what became of a baseline entity; the low two bits of its listing
+enum : uint8_t {
+    CODE_GONE = 0,
+    CODE_PREDICTED = 1,   // where its velocity puts it, within PREDICT_SLACK; never listed
+    CODE_CORRECTED = 2,   // + offset from there
+    CODE_CHANGED = 3,     // velocity, size or sprite changed; sent whole
+};
+
+// how far (in network units, a quarter pixel) the real position may be
+// from the predicted one before it is worth a correction
+static const int32_t PREDICT_SLACK = (int32_t)(NET_POS_SCALE / 4);
+// reserved for the four list counts, at most NET_MAX_ENTITIES each
+static const size_t COUNT_BYTES = 4 * 2;
+
+void ByteWriter::u8(uint8_t v) {
+    if (length == capacity) {
+        overflow = true;
+        return;
+    }
+    data[length++] = v;
+}
+
+void ByteWriter::u32(uint32_t v) {
+    for (int i = 0; i < 4; ++i) u8((uint8_t)(v >> (8 * i)));
+}
+
+void ByteWriter::varint(uint64_t v) {
+    while (v >= 0x80) {
+        u8((uint8_t)(v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    u8((uint8_t)v);
+}
+
+void ByteWriter::bytes(const void* src, size_t n) {
+    if (n > room()) {
+        overflow = true;
+        return;
+    }
+    memcpy(data + length, src, n);
+    length += n;
+}
+
+size_t ByteWriter::varintSize(uint64_t v) {
+    size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static size_t svarintSize(int64_t v) {
+    return ByteWriter::varintSize(((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+uint8_t ByteReader::u8() {
+    if (pos == length) {
+        good = false;
+        return 0;
+    }
+    return data[pos++];
+}
+
+uint32_t ByteReader::u32() {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= (uint32_t)u8() << (8 * i);
+    return v;
+}
+
+uint64_t ByteReader::varint() {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t c = u8();
+        v |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80)) return good ? v : 0;
+    }
+    good = false;
+    return 0;
+}
+
+const uint8_t* ByteReader::take(size_t n) {
+    if (n > length - pos) {
+        good = false;
+        return nullptr;
+    }
+    const uint8_t* p = data + pos;
+    pos += n;
+    return p;
+}
+
+void WorldState::reserve(size_t enemies, size_t bullets) {
+    Enemies.reserve(enemies);
+    Bullets.reserve(bullets);
+}
+
+static int32_t quantize(float v, float scale) {
+    return (int32_t)std::lround(v * scale);
+}
+
+static void captureList(const EntityStore& store, std::vector<NetEntity>& out) {
+    out.clear();
+    for (size_t i = 0; i < store.size(); ++i) {
+        EntityHandle h = store.handleAt(i);
+        NetEntity e;
+        e.Id = h.Slot;
+        e.Generation = h.Generation;
+        e.X = quantize(store.Position[i].x, NET_POS_SCALE);
+        e.Y = quantize(store.Position[i].y, NET_POS_SCALE);
+        e.VX = quantize(store.Velocity[i].x, NET_VEL_SCALE);
+        e.VY = quantize(store.Velocity[i].y, NET_VEL_SCALE);
+        e.W = (uint16_t)std::lround(store.Size[i].x);
+        e.H = (uint16_t)std::lround(store.Size[i].y);
+        e.Tex = store.TexID[i];
+        out.push_back(e);
+    }
+    std::sort(out.begin(), out.end(), [](const NetEntity& a, const NetEntity& b) { return a.Id < b.Id; });
+}
+
+void captureWorld(const Simulation& sim, uint8_t phase, WorldState& out) {
+    out.Tick = (uint32_t)sim.Tick;
+    out.Phase = phase;
+    out.Score = sim.Score;
+    out.Health = (int32_t)std::lround(sim.Player.Health);
+    out.Ships[0] = NetShip{ sim.Player.Position.x, sim.Player.Position.y };
+    out.Ships[1] = NetShip{ sim.Partner.Position.x, sim.Partner.Position.y };
+    captureList(sim.Enemies, out.Enemies);
+    captureList(sim.Bullets, out.Bullets);
+}
+
+int32_t predictPosition(int32_t pos, int32_t vel, int64_t ticks) {
+    // vel is per second; round half away from zero, the same on every machine
+    const int64_t rate = (int64_t)SIM_TICK_RATE;
+    int64_t n = (int64_t)vel * ticks;
+    int64_t d = n >= 0 ? (n + rate / 2) / rate : -((-n + rate / 2) / rate);
+    return (int32_t)(pos + d);
+}
+
+// a ship coordinate against the baseline's, as the difference of the bit
+// patterns: 1 byte while it stands still
+static void writeShip(ByteWriter& w, float v, float base) {
+    int32_t a, b;
+    memcpy(&a, &v, 4);
+    memcpy(&b, &base, 4);
+    w.svarint((int64_t)a - b);
+}
+
+static float readShip(ByteReader& r, float base) {
+    int32_t b;
+    memcpy(&b, &base, 4);
+    int32_t a = (int32_t)(b + r.svarint());
+    float v;
+    memcpy(&v, &a, 4);
+    return v;
+}
+
+static bool sameShape(const NetEntity& a, const NetEntity& b) {
+    return a.VX == b.VX && a.VY == b.VY && a.W == b.W && a.H == b.H && a.Tex == b.Tex;
+}
+
+// everything but the id
+static size_t bodySize(const NetEntity& e) {
+    return svarintSize(e.X) + svarintSize(e.Y) + svarintSize(e.VX) + svarintSize(e.VY) +
+        ByteWriter::varintSize(e.W) + ByteWriter::varintSize(e.H) + ByteWriter::varintSize(e.Tex);
+}
+
+static void writeBody(ByteWriter& w, const NetEntity& e) {
+    w.svarint(e.X);
+    w.svarint(e.Y);
+    w.svarint(e.VX);
+    w.svarint(e.VY);
+    w.varint(e.W);
+    w.varint(e.H);
+    w.varint(e.Tex);
+}
+
+static void readBody(ByteReader& r, NetEntity& e) {
+    e.X = (int32_t)r.svarint();
+    e.Y = (int32_t)r.svarint();
+    e.VX = (int32_t)r.svarint();
+    e.VY = (int32_t)r.svarint();
+    e.W = (uint16_t)r.varint();
+    e.H = (uint16_t)r.varint();
+    e.Tex = (uint32_t)r.varint();
+}
+
+SnapshotCodec::SnapshotCodec() {
+    for (ListScratch* s : { &enemies, &bullets }) {
+        s->Fresh.reserve(NET_MAX_ENTITIES);
+        s->Kept.reserve(NET_MAX_ENTITIES);
+        s->Added.reserve(NET_MAX_ENTITIES);
+    }
+    buffers.resize(4 * NET_MAX_PACKET);
+}
+
+void SnapshotCodec::diffList(const std::vector<NetEntity>& base, const std::vector<NetEntity>& cur, int64_t ticks,
+    ListScratch& s, size_t& budget, ByteWriter& listed) {
+    s.Listed = 0;
+    s.Fresh.clear();
+    s.Kept.clear();
+    // every listing is its distance from the last one listed, shifted
+    // left past the code
+    size_t next = 0;
+    auto list = [&](size_t i, uint8_t code, size_t payload) {
+        uint64_t head = (uint64_t)(i - next) << 2 | code;
+        size_t size = ByteWriter::varintSize(head) + payload;
+        if (size > budget) return false;
+        listed.varint(head);
+        budget -= size;
+        next = i + 1;
+        s.Listed++;
+        return true;
+    };
+
+    size_t j = 0;
+    for (size_t i = 0; i < base.size(); ++i) {
+        const NetEntity& b = base[i];
+        while (j < cur.size() && cur[j].Id < b.Id) {
+            if (s.Fresh.size() < s.Fresh.capacity()) s.Fresh.push_back((uint32_t)j);
+            j++;
+        }
+        NetEntity p = b;
+        p.X = predictPosition(b.X, b.VX, ticks);
+        p.Y = predictPosition(b.Y, b.VY, ticks);
+        if (j == cur.size() || cur[j].Id != b.Id || cur[j].Generation != b.Generation) {
+            // a reused slot is a different entity: this one goes, the new
+            // one is picked up as fresh by the loop above. Without room to
+            // say so it flies on as predicted until there is.
+            if (!list(i, CODE_GONE, 0)) s.Kept.push_back(p);
+            continue;
+        }
+        const NetEntity& c = cur[j++];
+
+        if (!sameShape(b, c)) {
+            if (list(i, CODE_CHANGED, bodySize(c))) {
+                writeBody(listed, c);
+                s.Kept.push_back(c);
+            }
+            else s.Kept.push_back(p);
+        }
+        else if (std::abs(c.X - p.X) <= PREDICT_SLACK && std::abs(c.Y - p.Y) <= PREDICT_SLACK) {
+            s.Kept.push_back(p);
+        }
+        else if (list(i, CODE_CORRECTED, svarintSize(c.X - p.X) + svarintSize(c.Y - p.Y))) {
+            listed.svarint(c.X - p.X);
+            listed.svarint(c.Y - p.Y);
+            p.X = c.X;
+            p.Y = c.Y;
+            s.Kept.push_back(p);
+        }
+        // else it stays where the prediction says until there is room
+        else s.Kept.push_back(p);
+    }
+    for (; j < cur.size() && s.Fresh.size() < s.Fresh.capacity(); ++j) s.Fresh.push_back((uint32_t)j);
+}
+
+void SnapshotCodec::addFresh(const std::vector<NetEntity>& cur, ListScratch& s, size_t& budget, ByteWriter& out) {
+    s.Added.clear();
+    for (uint32_t i : s.Fresh) {
+        if (s.Kept.size() + s.Added.size() == NET_MAX_ENTITIES) break;
+        const NetEntity& e = cur[i];
+        size_t size = ByteWriter::varintSize(e.Id) + bodySize(e);
+        if (size > budget) break;
+        out.varint(e.Id);
+        writeBody(out, e);
+        budget -= size;
+        s.Added.push_back(e);
+    }
+}
+
+void SnapshotCodec::merge(const ListScratch& s, std::vector<NetEntity>& out) {
+    out.clear();
+    std::merge(s.Kept.begin(), s.Kept.end(), s.Added.begin(), s.Added.end(), std::back_inserter(out),
+        [](const NetEntity& a, const NetEntity& b) { return a.Id < b.Id; });
+}
+
+// Layout: phase, score, health, both ships (relative to the baseline's
+// when there is one), then for enemies and bullets the count of listed
+// baseline entities and their listings, then new bullets, new enemies,
+// each a count and the entities. New bullets go first so a burst of
+// spawning enemies cannot hold up the shots.
+void SnapshotCodec::encode(const WorldState& cur, const WorldState* base, ByteWriter& out, WorldState& sent) {
+    static const WorldState empty;
+    const WorldState& b = base ? *base : empty;
+    int64_t ticks = base ? (int64_t)cur.Tick - (int64_t)base->Tick : 0;
+
+    out.u8(cur.Phase);
+    out.varint(cur.Score);
+    out.svarint(cur.Health);
+    for (int i = 0; i < 2; ++i) {
+        writeShip(out, cur.Ships[i].X, b.Ships[i].X);
+        writeShip(out, cur.Ships[i].Y, b.Ships[i].Y);
+    }
+
+    size_t budget = out.room() > COUNT_BYTES ? out.room() - COUNT_BYTES : 0;
+    ByteWriter enemyList(&buffers[0], NET_MAX_PACKET), bulletList(&buffers[NET_MAX_PACKET], NET_MAX_PACKET);
+    ByteWriter newBullets(&buffers[2 * NET_MAX_PACKET], NET_MAX_PACKET), newEnemies(&buffers[3 * NET_MAX_PACKET], NET_MAX_PACKET);
+    diffList(b.Enemies, cur.Enemies, ticks, enemies, budget, enemyList);
+    diffList(b.Bullets, cur.Bullets, ticks, bullets, budget, bulletList);
+    addFresh(cur.Bullets, bullets, budget, newBullets);
+    addFresh(cur.Enemies, enemies, budget, newEnemies);
+
+    out.varint(enemies.Listed);
+    out.bytes(enemyList.begin(), enemyList.size());
+    out.varint(bullets.Listed);
+    out.bytes(bulletList.begin(), bulletList.size());
+    out.varint(bullets.Added.size());
+    out.bytes(newBullets.begin(), newBullets.size());
+    out.varint(enemies.Added.size());
+    out.bytes(newEnemies.begin(), newEnemies.size());
+
+    sent.Tick = cur.Tick;
+    sent.Phase = cur.Phase;
+    sent.Score = cur.Score;
+    sent.Health = cur.Health;
+    sent.Ships[0] = cur.Ships[0];
+    sent.Ships[1] = cur.Ships[1];
+    merge(enemies, sent.Enemies);
+    merge(bullets, sent.Bullets);
+}
+
+bool SnapshotCodec::decodeList(ByteReader& in, const std::vector<NetEntity>& base, int64_t ticks,
+    ListScratch& s, std::vector<NetEntity>* removed) {
+    s.Kept.clear();
+    uint64_t listed = in.varint();
+    if (listed > base.size()) return false;
+    // index and code of the next listed entity
+    uint64_t next = base.size(), code = CODE_PREDICTED;
+    bool waiting = false;
+    auto readListing = [&](uint64_t from) {
+        waiting = listed > 0;
+        if (!waiting) return;
+        listed--;
+        uint64_t head = in.varint();
+        next = from + (head >> 2);
+        code = head & 3;
+    };
+    readListing(0);
+    for (size_t i = 0; i < base.size(); ++i) {
+        NetEntity e = base[i];
+        uint64_t c = waiting && i == next ? code : (uint64_t)CODE_PREDICTED;
+        if (c == CODE_GONE) {
+            if (removed && removed->size() < removed->capacity()) removed->push_back(e);
+        }
+        else if (c == CODE_CHANGED) readBody(in, e);
+        else {
+            e.X = predictPosition(e.X, e.VX, ticks);
+            e.Y = predictPosition(e.Y, e.VY, ticks);
+            if (c == CODE_CORRECTED) {
+                e.X += (int32_t)in.svarint();
+                e.Y += (int32_t)in.svarint();
+            }
+        }
+        if (c != CODE_GONE) s.Kept.push_back(e);
+        if (waiting && i == next) readListing(i + 1);
+    }
+    // every listing must have landed on an entity
+    return in.ok() && !waiting;
+}
+
+static bool readFresh(ByteReader& in, size_t kept, std::vector<NetEntity>& added) {
+    added.clear();
+    uint64_t count = in.varint();
+    if (kept + count > NET_MAX_ENTITIES) return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        NetEntity e;
+        e.Id = (uint32_t)in.varint();
+        e.Generation = 0;
+        readBody(in, e);
+        // ascending, or the merge would not hold
+        if (!added.empty() && e.Id <= added.back().Id) return false;
+        added.push_back(e);
+    }
+    return in.ok();
+}
+
+bool SnapshotCodec::decode(ByteReader& in, const WorldState* base, uint32_t tick, WorldState& out,
+    std::vector<NetEntity>* removed) {
+    static const WorldState empty;
+    const WorldState& b = base ? *base : empty;
+    int64_t ticks = base ? (int64_t)tick - (int64_t)base->Tick : 0;
+
+    out.Tick = tick;
+    out.Phase = in.u8();
+    out.Score = (uint32_t)in.varint();
+    out.Health = (int32_t)in.svarint();
+    for (int i = 0; i < 2; ++i) {
+        out.Ships[i].X = readShip(in, b.Ships[i].X);
+        out.Ships[i].Y = readShip(in, b.Ships[i].Y);
+    }
+    if (!decodeList(in, b.Enemies, ticks, enemies, removed) ||
+        !decodeList(in, b.Bullets, ticks, bullets, nullptr) ||
+        !readFresh(in, bullets.Kept.size(), bullets.Added) ||
+        !readFresh(in, enemies.Kept.size(), enemies.Added))
+        return false;
+    merge(enemies, out.Enemies);
+    merge(bullets, out.Bullets);
+    return true;
+}
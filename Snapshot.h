@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class EntityStore;
+class Simulation;
+
+// Network units: positions in 1/64 px, velocities in 1/64 px/s, sizes in
+// whole px. Far finer than anything visible, so that predicting an entity
+// snapshot after snapshot drifts slowly and it rarely needs correcting.
+const float NET_POS_SCALE = 64.f;
+const float NET_VEL_SCALE = 64.f;
+// a snapshot is one UDP datagram, kept under a 1500-byte Ethernet MTU
+const size_t NET_MAX_PACKET = 1400;
+// per entity list and snapshot; beyond it the rest wait for a later one
+const size_t NET_MAX_ENTITIES = 2048;
+
+// Little-endian bytes and LEB128 varints (zigzag for signed values), into
+// a fixed buffer. Writing past the end sets overflowed() and drops the rest.
+class ByteWriter {
+public:
+    ByteWriter(uint8_t* data, size_t capacity) : data(data), capacity(capacity) {}
+    void u8(uint8_t v);
+    void u32(uint32_t v);
+    void varint(uint64_t v);
+    void svarint(int64_t v) { varint(((uint64_t)v << 1) ^ (uint64_t)(v >> 63)); }
+    void bytes(const void* src, size_t n);
+    size_t size() const { return length; }
+    size_t room() const { return capacity - length; }
+    bool overflowed() const { return overflow; }
+    const uint8_t* begin() const { return data; }
+    static size_t varintSize(uint64_t v);
+
+private:
+    uint8_t* data;
+    size_t   capacity;
+    size_t   length = 0;
+    bool     overflow = false;
+};
+
+// Reading past the end, or a varint longer than 64 bits, clears ok() and
+// returns zeros from then on.
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t length) : data(data), length(length) {}
+    uint8_t  u8();
+    uint32_t u32();
+    uint64_t varint();
+    int64_t  svarint() { uint64_t v = varint(); return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+    const uint8_t* take(size_t n);   // n bytes in place, nullptr if there are fewer
+    bool ok() const { return good; }
+    bool atEnd() const { return pos == length; }
+
+private:
+    const uint8_t* data;
+    size_t length;
+    size_t pos = 0;
+    bool   good = true;
+};
+
+// One bullet or enemy, quantized.
+struct NetEntity {
+    uint32_t Id;           // EntityStore slot
+    uint32_t Generation;   // the host's, to tell a reused slot apart; never sent
+    int32_t  X, Y;
+    int32_t  VX, VY;
+    uint16_t W, H;
+    uint32_t Tex;
+};
+
+// Ships go exactly, not quantized: the partner replays its own inputs on
+// top of its ship, and that has to start where the host's really is.
+struct NetShip {
+    float X = 0.f, Y = 0.f;
+};
+
+// Everything a snapshot carries, quantized. Entity lists are in ascending
+// Id order so two states line up in one merge pass.
+struct WorldState {
+    uint32_t Tick = 0;     // the host's Simulation::Tick
+    uint8_t  Phase = 0;    // the host's game state (WELCOME, PLAYING, ...)
+    uint32_t Score = 0;
+    int32_t  Health = 0;
+    NetShip  Ships[2];     // host, partner
+    std::vector<NetEntity> Enemies;
+    std::vector<NetEntity> Bullets;
+
+    void reserve(size_t enemies, size_t bullets);
+};
+
+// quantize the simulation into `out`, which should be reserved for its pools
+void captureWorld(const Simulation& sim, uint8_t phase, WorldState& out);
+// where an entity is `ticks` after the state it is in, as both ends of the
+// connection compute it
+int32_t predictPosition(int32_t pos, int32_t vel, int64_t ticks);
+
+// Delta codec. An entity of the baseline that is where its velocity
+// predicts it (within a quarter pixel) costs nothing; the others are
+// listed by their distance from the previous one listed, as gone,
+// corrected by a small offset, or changed outright. Entities the baseline
+// does not have are sent whole. Everything in this game flies in straight
+// lines, so a steady screen of hundreds of enemies is a few bytes of
+// header plus the ones that were shot down or drifted.
+//
+// Whatever does not fit in the packet (new entities first, then
+// corrections, then removals) is left for a later snapshot. The encoder
+// therefore hands back exactly the state a decoder ends up with, and that,
+// not the real world, is what later snapshots are encoded against.
+class SnapshotCodec {
+public:
+    // takes all its scratch up front, so neither side allocates per snapshot
+    SnapshotCodec();
+
+    // writes `cur` against `base` (nullptr: no baseline, everything is new)
+    // into `out` and sets `sent` to what the receiver will decode
+    void encode(const WorldState& cur, const WorldState* base, ByteWriter& out, WorldState& sent);
+    // the inverse; `base` must be the state the sender encoded against.
+    // Enemies that were in the baseline and are gone land in `removed`.
+    bool decode(ByteReader& in, const WorldState* base, uint32_t tick, WorldState& out,
+        std::vector<NetEntity>* removed = nullptr);
+
+private:
+    struct ListScratch {
+        uint32_t               Listed = 0;   // baseline entities that were not as predicted
+        std::vector<uint32_t>  Fresh;        // indices into cur of entities the baseline lacks
+        std::vector<NetEntity> Kept, Added;
+    };
+    void diffList(const std::vector<NetEntity>& base, const std::vector<NetEntity>& cur, int64_t ticks,
+        ListScratch& s, size_t& budget, ByteWriter& listed);
+    void addFresh(const std::vector<NetEntity>& cur, ListScratch& s, size_t& budget, ByteWriter& out);
+    bool decodeList(ByteReader& in, const std::vector<NetEntity>& base, int64_t ticks,
+        ListScratch& s, std::vector<NetEntity>* removed);
+    static void merge(const ListScratch& s, std::vector<NetEntity>& out);
+
+    ListScratch enemies, bullets;
+    std::vector<uint8_t> buffers;   // the sections encode() assembles the packet from
+};
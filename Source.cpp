@@ -2,14 +2,28 @@
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-#include "stb_easy_font.h"
 
 #define MINIAUDIO_IMPLEMENTATION
 #include "SDL3/miniaudio.h"
 
+#include "FrameArena.h"
+#include "FramePacer.h"
+#include "Headless.h"
+#include "InputQueue.h"
+#include "JobSystem.h"
+#include "Net.h"
+#include "ParticleSystem.h"
+#include "AssetPack.h"
+#include "Audio.h"
+#include "DynamicResolution.h"
+#include "Profiler.h"
+#include "RenderQueue.h"
+#include "Replay.h"
+#include "Simulation.h"
+#include "StreamBuffer.h"
+#include "Telemetry.h"
+#include "TextMesh.h"
+
 #include <iostream>
 #include <vector>
 #include <fstream>
@@ -17,81 +31,269 @@
 #include <cstdlib>
 #include <ctime>
 #include <algorithm>
-
-// screen
+#include <atomic>
+#include <chrono>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#ifndef NDEBUG
+// Debug builds count every heap allocation; once PLAYING has settled, a
+// frame that allocates trips an assert in the game loop
+std::atomic<uint64_t> heapAllocs{ 0 };
+void* operator new(size_t n) {
+    heapAllocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// frames of PLAYING to let caches and pools warm up before checking
+const int ALLOC_CHECK_WARMUP_FRAMES = 120;
+bool allocCheckSkip = false;   // set for a frame that is allowed to allocate
+#endif
+
+#ifndef _MSC_VER
+// the headless build is Linux-only and has no MSVC CRT
+template <size_t N, class... Args>
+int sprintf_s(char (&buf)[N], const char* fmt, Args... args) { return snprintf(buf, N, fmt, args...); }
+#endif
+
+// window size at startup; everything is drawn in WORLD_WIDTH x WORLD_HEIGHT
+// units and scaled to whatever the window or render scale turns out to be
 const unsigned int SCR_WIDTH = 1920;
 const unsigned int SCR_HEIGHT = 1080;
 
+// The scene is drawn into sceneTarget at a fraction of the output size
+// (dynamicRes picks it) and then stretched over the output, letterboxed
+// to the world's aspect ratio.
+RenderTarget sceneTarget;
+DynamicResolution dynamicRes;
+
+// the largest rect of the world's aspect that fits in outW x outH, centred
+void letterbox(int outW, int outH, int& x0, int& y0, int& x1, int& y1) {
+    int w = outW, h = (int)(outW * WORLD_HEIGHT / WORLD_WIDTH + 0.5f);
+    if (h > outH) {
+        h = outH;
+        w = (int)(outH * WORLD_WIDTH / WORLD_HEIGHT + 0.5f);
+    }
+    x0 = (outW - w) / 2;
+    y0 = (outH - h) / 2;
+    x1 = x0 + w;
+    y1 = y0 + h;
+}
+
 // game states
 enum GameState { WELCOME, INSTRUCTIONS, PLAYING, GAME_OVER };
 GameState state = WELCOME;
 
-// timing
+// timing: deltaTime is the real frame time; gameplay advances in fixed
+// SIM_DT ticks and is drawn interpolated between the last two of them
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
+float simAccumulator = 0.0f;
 
-// player
-struct Entity {
-    glm::vec2 Position;
-    glm::vec2 Size;
-    glm::vec3 Color;
-    float     Health;
-};
-Entity Player;
+// player, bullets, enemies, stars and score (see Simulation.h)
+Simulation sim(0);
 
-// bullets
-struct Bullet {
-    glm::vec2 Position;
-    glm::vec2 Velocity;
-    glm::vec3 Color;
-};
-std::vector<Bullet> Bullets;
-
-// enemies
-struct Enemy {
-    glm::vec2 Position;
-    glm::vec2 Size;
-    float     Speed;
-    GLuint    TexID;
-};
-std::vector<Enemy> Enemies;
+// co-op (--host / --join, see Net.h). The host's sim flies the partner's
+// ship too; a client runs no sim at all, so `sim` sits idle and the view
+// is filled from netClient instead.
+NetHost netHost;
+NetClient netClient;
+bool netJoined = false;
 
-// starfield for background
-std::vector<glm::vec2> Stars;
+// transient per-frame render data (queued text); reset every frame
+FrameArena frameArena(1 << 20);
+const glm::vec3 BULLET_COLOR(1.f, 0.8f, 0.2f);
 
 // scores
-unsigned int score = 0, highScore = 0;
-
-ma_engine engine;
-ma_sound shootSound;
-
-// shader program & quad
-unsigned int shaderProgram, VAO, VBO;
-
-// for textured enemies
+unsigned int highScore = 0;
+
+// Session log with the high-score table in it (see Telemetry.h); off for
+// replays and headless runs. The sim job never pushes to it: it leaves its
+// records in simFrame for the main thread, the log's one producer.
+TelemetryLog telemetry;
+bool telemetryOn = false;
+// frame times are logged as percentiles over windows this long
+const float TELEMETRY_WINDOW_SECONDS = 10.f;
+
+// sprites and sounds, mapped from the pack built by tools/AssetPacker.cpp;
+// the sound voices play straight out of the mapping, so it outlives audio
+AssetPack assets;
+AudioSystem audio;
+SoundId shootSound = INVALID_SOUND;
+
+// unit quad, plus the text program & its VAO (glyph instances come from streamVBO)
+unsigned int VAO, VBO;
+ProgramId textProgram;
+unsigned int textVAO;
+
+// the font, rasterized at startup; one texture, one quad per character
+GlyphAtlas glyphAtlas;
+GLuint fontTexture = 0;
+
+// textured quads: every sprite is a rect in one atlas texture
 GLuint texVAO, texVBO;
-std::vector<GLuint> enemyTextures;
-unsigned int shaderProgramTex;
-std::vector<GLuint> playerTextures;
+GLuint atlasTexture = 0;
+std::vector<glm::vec4> enemySprites;   // uv offset.xy, uv scale.zw
+glm::vec4 playerSprite;
+
+// every draw of a frame is recorded here and issued, sorted, after the
+// last of them; the projection lives in its Frame uniform block
+RenderQueue renderQueue;
 
-// simple vertex+fragment
+// text: one instance per character with its screen rect, glyph uv rect
+// and color, so any number of strings can share one draw
 const char* vertexSrc = R"(
 #version 330 core
 layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aTex;
+layout (location = 2) in vec4 iRect;    // xy = position, zw = size
+layout (location = 3) in vec4 iUV;      // xy = uv offset, zw = uv scale
+layout (location = 4) in vec3 iColor;
 
-uniform mat4 projection;
-uniform mat4 model;
+layout (std140) uniform Frame {
+    mat4 projection;
+};
+out vec2 TexCoord;
+out vec3 Color;
 
 void main(){
-    gl_Position = projection * model * vec4(aPos,0.0,1.0);
+    TexCoord = iUV.xy + aTex * iUV.zw;
+    Color = iColor;
+    gl_Position = projection * vec4(iRect.xy + aPos * iRect.zw, 0.0, 1.0);
 }
 )";
 const char* fragmentSrc = R"(
 #version 330 core
+in vec2 TexCoord;
+in vec3 Color;
 out vec4 FragColor;
-uniform vec3 color;
+uniform sampler2D font;
 void main(){
-    FragColor = vec4(color,1.0);
+    FragColor = vec4(Color, texture(font, TexCoord).r);
+}
+)";
+
+// instanced variants: the unit quad comes from VAO/texVAO, every other
+// per-sprite value comes from the instance buffer
+const char* vertexSrcInst = R"(
+#version 330 core
+layout (location = 0) in vec2 aPos;
+layout (location = 2) in vec4 iRect;   // xy = position, zw = size
+layout (location = 3) in vec4 iColor;
+
+layout (std140) uniform Frame {
+    mat4 projection;
+};
+out vec4 Color;
+
+void main(){
+    Color = iColor;
+    gl_Position = projection * vec4(iRect.xy + aPos * iRect.zw, 0.0, 1.0);
+}
+)";
+const char* fragmentSrcInst = R"(
+#version 330 core
+in vec4 Color;
+out vec4 FragColor;
+void main(){
+    FragColor = Color;
+}
+)";
+const char* vertexSrcTexInst = R"(
+#version 330 core
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aTex;
+layout (location = 2) in vec4 iRect;   // xy = position, zw = size
+layout (location = 3) in vec4 iUV;     // xy = uv offset, zw = uv scale
+
+layout (std140) uniform Frame {
+    mat4 projection;
+};
+out vec2 TexCoord;
+
+void main(){
+    TexCoord = iUV.xy + aTex * iUV.zw;
+    gl_Position = projection * vec4(iRect.xy + aPos * iRect.zw, 0.0, 1.0);
+}
+)";
+const char* fragmentSrcTexInst = R"(
+#version 330 core
+in vec2 TexCoord;
+out vec4 FragColor;
+uniform sampler2D atlas;
+void main(){
+    FragColor = texture(atlas, TexCoord);
+}
+)";
+
+// starfield: one point per star, scrolled entirely in the vertex shader.
+// z picks the parallax layer (0 = farthest); far stars are smaller, dimmer
+// and slower. Layer 1 matches the old 2px, 50 px/s stars.
+const char* vertexSrcStars = R"(
+#version 330 core
+layout (location = 0) in vec4 aStar;   // xy = seed position, z = layer, w = twinkle phase
+
+layout (std140) uniform Frame {
+    mat4 projection;
+};
+uniform float time;
+uniform float width;
+out float Brightness;
+
+const float SPEED[3] = float[3](20.0, 50.0, 110.0);
+const float SIZE[3]  = float[3](1.0, 2.0, 3.0);
+
+void main(){
+    int layer = int(aStar.z);
+    float x = mod(aStar.x - time * SPEED[layer], width);
+    Brightness = (0.45 + 0.275 * aStar.z) * (0.85 + 0.15 * sin(time * 3.0 + aStar.w));
+    gl_PointSize = SIZE[layer];
+    gl_Position = projection * vec4(x, aStar.y, 0.0, 1.0);
+}
+)";
+const char* fragmentSrcStars = R"(
+#version 330 core
+in float Brightness;
+out vec4 FragColor;
+void main(){
+    FragColor = vec4(vec3(Brightness), 1.0);
+}
+)";
+
+// particles: unit quad centred on each instance, round and soft-edged,
+// drawn additively so dense clouds glow
+const char* vertexSrcParticles = R"(
+#version 330 core
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec3 iParticle;   // xy = centre, z = size
+layout (location = 2) in vec4 iColor;
+layout (std140) uniform Frame {
+    mat4 projection;
+};
+out vec2 Offset;
+out vec4 Color;
+void main(){
+    Offset = aPos - 0.5;
+    Color = iColor;
+    gl_Position = projection * vec4(iParticle.xy + Offset * iParticle.z, 0.0, 1.0);
+}
+)";
+const char* fragmentSrcParticles = R"(
+#version 330 core
+in vec2 Offset;
+in vec4 Color;
+out vec4 FragColor;
+void main(){
+    float edge = 1.0 - smoothstep(0.25, 0.5, length(Offset));
+    FragColor = vec4(Color.rgb, Color.a * edge);
 }
 )";
 
@@ -122,9 +324,234 @@ unsigned int createProgram(const char* vs, const char* fs) {
     return p;
 }
 
+// sprite batching: every quad of a frame becomes one instance, and each
+// layer is drawn with a single glDrawArraysInstanced
+struct SpriteInstance {
+    glm::vec4 Rect;      // position.xy, size.xy
+    glm::vec4 ColorUV;   // rgba for solid layers, atlas uv rect for textured ones
+};
+
+struct SpriteLayer {
+    bool textured = false;
+    std::vector<SpriteInstance> instances;
+};
+
+// draw order, back to front
+enum SpriteLayerId { LAYER_BULLETS, LAYER_ACTORS, LAYER_HUD, LAYER_COUNT };
+SpriteLayer spriteLayers[LAYER_COUNT];
+
+// render queue layers, back to front; sprite layer i is DRAW_SPRITES + i
+enum DrawLayer { DRAW_STARS, DRAW_SPRITES, DRAW_PARTICLES = DRAW_SPRITES + LAYER_COUNT, DRAW_TEXT };
+
+// per-frame counters so the batching can be checked against the old path
+struct RenderStats {
+    unsigned int drawCalls = 0;
+    unsigned int instances = 0;
+    unsigned int bufferUploads = 0;   // writes into the stream buffer
+    unsigned int glyphs = 0;          // text quads, one per visible character
+};
+RenderStats frameStats;
+
+// GL_TIME_ELAPSED timers around render sections. A frame's queries are read
+// back GPU_TIMER_FRAMES frames later, by which time they are done, so the
+// CPU never waits on the GPU. Sections must not nest.
+const int GPU_TIMER_FRAMES = 4;
+const int GPU_TIMERS_PER_FRAME = 8;
+struct GpuTimerFrame {
+    GLuint      Queries[GPU_TIMERS_PER_FRAME];
+    const char* Names[GPU_TIMERS_PER_FRAME];
+    double      StartUs[GPU_TIMERS_PER_FRAME];
+    int         Count = 0;
+};
+GpuTimerFrame gpuTimers[GPU_TIMER_FRAMES];
+int  gpuTimerFrame = 0;
+bool gpuTimerOpen = false;
+
+void initGpuTimers() {
+    for (GpuTimerFrame& f : gpuTimers)
+        glGenQueries(GPU_TIMERS_PER_FRAME, f.Queries);
+}
+
+void beginGpuTimer(const char* name) {
+    GpuTimerFrame& f = gpuTimers[gpuTimerFrame];
+    if (f.Count == GPU_TIMERS_PER_FRAME) return;
+    f.Names[f.Count] = name;
+    f.StartUs[f.Count] = gProfiler.nowUs();
+    glBeginQuery(GL_TIME_ELAPSED, f.Queries[f.Count]);
+    gpuTimerOpen = true;
+}
+
+void endGpuTimer() {
+    if (!gpuTimerOpen) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    gpuTimers[gpuTimerFrame].Count++;
+    gpuTimerOpen = false;
+}
+
+// move on to the oldest frame's queries: report them, then reuse them
+void nextGpuTimerFrame() {
+    gpuTimerFrame = (gpuTimerFrame + 1) % GPU_TIMER_FRAMES;
+    GpuTimerFrame& f = gpuTimers[gpuTimerFrame];
+    for (int i = 0; i < f.Count; ++i) {
+        GLint ready = 0;
+        glGetQueryObjectiv(f.Queries[i], GL_QUERY_RESULT_AVAILABLE, &ready);
+        if (!ready) continue;   // a very deep GPU queue; skip rather than stall
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(f.Queries[i], GL_QUERY_RESULT, &ns);
+        gProfiler.addGpuTime(f.Names[i], f.StartUs[i], ns / 1e6);
+    }
+    f.Count = 0;
+}
+
+ProgramId spriteProgram, spriteProgramTex;
+
+// every per-frame vertex stream (sprite instances, text) is written into
+// this one fenced ring; see StreamBuffer.h
+StreamBuffer streamVBO;
+const size_t STREAM_SEGMENT_BYTES = 1 << 20;
+
+// point the per-instance attributes of the bound sprite VAO at a byte
+// offset in streamVBO
+void spriteAttribs(size_t baseOffset) {
+    glBindBuffer(GL_ARRAY_BUFFER, streamVBO.buffer());
+    GLsizei stride = sizeof(SpriteInstance);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*)(baseOffset + offsetof(SpriteInstance, Rect)));
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride, (void*)(baseOffset + offsetof(SpriteInstance, ColorUV)));
+}
+
+// Particles live outside the simulation: emitted on the main thread from
+// what the last ticks reported, updated on the job system and drawn with
+// one instanced call straight from streamVBO.
+ParticleSystem particles(0);
+const float PLAYER_TRAIL_RATE = 400.f;   // per second
+ProgramId particleProgram;
+unsigned int particleVAO;
+float trailCarry = 0.f;   // fraction of a trail particle owed from last frame
+
+// explosion plus sparks where an enemy was shot down
+void emitExplosion(glm::vec2 pos) {
+    ParticleBurst debris;
+    debris.Count = 160;
+    debris.SpeedMin = 40.f;  debris.SpeedMax = 260.f;
+    debris.LifeMin = 0.4f;   debris.LifeMax = 1.2f;
+    debris.SizeMin = 4.f;    debris.SizeMax = 10.f;
+    debris.Color = 0xff2070ffu;   // orange
+    particles.emit(pos, debris);
+
+    ParticleBurst sparks;
+    sparks.Count = 60;
+    sparks.SpeedMin = 300.f; sparks.SpeedMax = 700.f;
+    sparks.LifeMin = 0.1f;   sparks.LifeMax = 0.35f;
+    sparks.SizeMin = 2.f;    sparks.SizeMax = 3.f;
+    sparks.Color = 0xff80f0ffu;   // pale yellow
+    sparks.Angle = 3.14159265f;   // back towards the shooter
+    sparks.Spread = 2.f;
+    particles.emit(pos, sparks);
+}
+
+// engine exhaust behind the player, `rate` particles per second
+void emitTrail(const Entity& player, float dt, float rate) {
+    trailCarry += rate * dt;
+    ParticleBurst trail;
+    trail.Count = (int)trailCarry;
+    trailCarry -= trail.Count;
+    trail.SpeedMin = 80.f;   trail.SpeedMax = 200.f;
+    trail.LifeMin = 0.15f;   trail.LifeMax = 0.45f;
+    trail.SizeMin = 3.f;     trail.SizeMax = 6.f;
+    trail.Color = 0xc0ffa040u;   // blue-white
+    trail.Angle = 3.14159265f;
+    trail.Spread = 0.5f;
+    particles.emit(player.Position + glm::vec2(0.f, player.Size.y * 0.5f), trail);
+}
+
+void particleAttribs(size_t base) {
+    glBindBuffer(GL_ARRAY_BUFFER, streamVBO.buffer());
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)(base + offsetof(ParticleInstance, X)));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ParticleInstance), (void*)(base + offsetof(ParticleInstance, Color)));
+}
+
+void drawParticles(JobSystem& jobs) {
+    PROFILE_SCOPE("drawParticles");
+    size_t n = particles.size();
+    size_t base = 0;
+    ParticleInstance* dst = n ? (ParticleInstance*)streamVBO.map(n * sizeof(ParticleInstance), base) : nullptr;
+    if (!dst) return;
+    particles.writeInstances(dst, &jobs);
+    streamVBO.unmap();
+    frameStats.bufferUploads++;
+
+    DrawCommand c;
+    c.Layer = DRAW_PARTICLES;
+    c.Program = particleProgram;
+    c.Vao = particleVAO;
+    c.Blend = BLEND_ADD;
+    c.Count = 6;
+    c.Instances = (GLsizei)n;
+    c.Attribs = particleAttribs;
+    c.StreamOffset = base;
+    if (renderQueue.push(c)) frameStats.drawCalls++;
+}
+
+// starfield: static seeds, animated by the time uniform
+ProgramId starProgram;
+unsigned int starVAO, starVBO;
+GLint starTimeLoc;
+GLsizei starCount = 0;
+
+// `count` stars spread over the screen, three parallax layers with most
+// stars in the far ones; positions come from the game seed
+void initStarfield(int count, uint64_t seed) {
+    Rng rng(seed ^ 0x5354415253ull);   // its own stream, so spawns are unaffected
+    std::vector<float> stars;
+    stars.reserve((size_t)count * 4);
+    for (int i = 0; i < count; ++i) {
+        uint32_t r = rng.below(100);
+        stars.push_back((float)rng.below((uint32_t)WORLD_WIDTH));
+        stars.push_back((float)rng.below((uint32_t)WORLD_HEIGHT));
+        stars.push_back(r < 60 ? 0.f : (r < 90 ? 1.f : 2.f));
+        stars.push_back((float)rng.below(6283) / 1000.f);
+    }
+    starCount = count;
+
+    starProgram = renderQueue.addProgram(createProgram(vertexSrcStars, fragmentSrcStars));
+    glUseProgram(renderQueue.program(starProgram));
+    glUniform1f(renderQueue.uniform(starProgram, "width"), WORLD_WIDTH);
+    starTimeLoc = renderQueue.uniform(starProgram, "time");
+    glUseProgram(0);
+
+    glGenVertexArrays(1, &starVAO);
+    glGenBuffers(1, &starVBO);
+    glBindVertexArray(starVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, starVBO);
+    glBufferData(GL_ARRAY_BUFFER, stars.size() * sizeof(float), stars.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    glEnable(GL_PROGRAM_POINT_SIZE);
+}
+
+// background for every screen; `time` is simulation time so it scrolls
+// in step with the game and pauses with it
+void drawStarfield(float time) {
+    if (!starCount) return;
+    DrawCommand c;
+    c.Layer = DRAW_STARS;
+    c.Program = starProgram;
+    c.Vao = starVAO;
+    c.Primitive = GL_POINTS;
+    c.Count = starCount;
+    c.FloatUniform = starTimeLoc;
+    c.FloatValue = time;
+    if (renderQueue.push(c)) frameStats.drawCalls++;
+}
+
+// draws per frame: a handful of layers, stars, particles and text
+const size_t RENDER_QUEUE_COMMANDS = 64;
+
 // set up a unit quad (0,0)-(1,1)
-void initRenderer() {
-    shaderProgram = createProgram(vertexSrc, fragmentSrc);
+void initRenderer(GLADloadproc getProc) {
     float quadVerts[] = {
         0,1,   1,0,   0,0,
         0,1,   1,1,   1,0
@@ -139,91 +566,220 @@ void initRenderer() {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
-    // enable alpha blending for smooth visuals
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-}
+    // setup a VAO/VBO for textured quads (pos + uv)
+    float quadData[] = {
+        // pos      // uv
+         0,1,       0,1,
+         1,0,       1,0,
+         0,0,       0,0,
+         0,1,       0,1,
+         1,1,       1,1,
+         1,0,       1,0
+    };
+    glGenVertexArrays(1, &texVAO);
+    glGenBuffers(1, &texVBO);
+    glBindVertexArray(texVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, texVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quadData), quadData, GL_STATIC_DRAW);
+    // pos attr
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    // uv attr
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    glBindVertexArray(0);
 
-// draw any colored rectangle
-void drawEntity(const Entity& e) {
-    glUseProgram(shaderProgram);
+    // instance attributes live on the same two VAOs, advancing once per quad
+    streamVBO.init(GL_ARRAY_BUFFER, STREAM_SEGMENT_BYTES, getProc);
+    std::cout << "stream buffer: " << (streamVBO.persistent() ? "persistent mapped" : "glMapBufferRange") << "\n";
+    GLuint vaos[] = { VAO, texVAO };
+    for (GLuint vao : vaos) {
+        glBindVertexArray(vao);
+        spriteAttribs(0);
+        for (GLuint loc = 2; loc <= 3; ++loc) {
+            glEnableVertexAttribArray(loc);
+            glVertexAttribDivisor(loc, 1);
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    // the programs take the projection from the queue's Frame block
+    renderQueue.init(RENDER_QUEUE_COMMANDS);
+    spriteProgram = renderQueue.addProgram(createProgram(vertexSrcInst, fragmentSrcInst));
+    spriteProgramTex = renderQueue.addProgram(createProgram(vertexSrcTexInst, fragmentSrcTexInst));
+    glUseProgram(renderQueue.program(spriteProgramTex));
+    glUniform1i(renderQueue.uniform(spriteProgramTex, "atlas"), 0);
+    glUseProgram(0);
+    textProgram = renderQueue.addProgram(createProgram(vertexSrc, fragmentSrc));
+    glUseProgram(renderQueue.program(textProgram));
+    glUniform1i(renderQueue.uniform(textProgram, "font"), 0);
+    glUseProgram(0);
+    particleProgram = renderQueue.addProgram(createProgram(vertexSrcParticles, fragmentSrcParticles));
+
+    // particles: the unit quad plus per-instance centre/size and color,
+    // pointed at this frame's instances in drawParticles
+    glGenVertexArrays(1, &particleVAO);
+    glBindVertexArray(particleVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    for (GLuint loc = 1; loc <= 2; ++loc) {
+        glEnableVertexAttribArray(loc);
+        glVertexAttribDivisor(loc, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
 
-    // projection orthographic, Y down-to-up
-    glm::mat4 proj = glm::ortho(0.f, (float)SCR_WIDTH, 0.f, (float)SCR_HEIGHT, -1.f, 1.f);
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(proj));
+    // text: the textured unit quad plus per-glyph instances, pointed at
+    // this frame's glyphs in flushText
+    glGenVertexArrays(1, &textVAO);
+    glBindVertexArray(textVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, texVBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    for (GLuint loc = 2; loc <= 4; ++loc) {
+        glEnableVertexAttribArray(loc);
+        glVertexAttribDivisor(loc, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
 
-    // model: translate & scale
-    glm::mat4 model = glm::translate(glm::mat4(1.f), glm::vec3(e.Position, 0.f));
-    model = glm::scale(model, glm::vec3(e.Size, 1.f));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
+    // coverage only; nearest keeps the pixel font as sharp as its strokes were
+    glGenTextures(1, &fontTexture);
+    glBindTexture(GL_TEXTURE_2D, fontTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, GlyphAtlas::WIDTH, GlyphAtlas::HEIGHT, 0, GL_RED, GL_UNSIGNED_BYTE, glyphAtlas.pixels());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
 
-    // color
-    glUniform3fv(glGetUniformLocation(shaderProgram, "color"), 1, glm::value_ptr(e.Color));
+    spriteLayers[LAYER_ACTORS].textured = true;
 
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+    // enable alpha blending for smooth visuals
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
-// for enemies and shooter
-void drawTexturedEntity(const Enemy& e) {
-    glUseProgram(shaderProgramTex);
-
-    // projection
-    glm::mat4 proj = glm::ortho(0.f, (float)SCR_WIDTH, 0.f, (float)SCR_HEIGHT, -1.f, 1.f);
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgramTex, "projection"), 1, GL_FALSE, glm::value_ptr(proj));
+// size the layers for the largest frame the pools allow, so queueing never allocates
+void reserveSprites(const SimConfig& config) {
+    spriteLayers[LAYER_BULLETS].instances.reserve(config.MaxBullets);
+    spriteLayers[LAYER_ACTORS].instances.reserve(config.MaxEnemies + 2);
+    spriteLayers[LAYER_HUD].instances.reserve(16);
+}
 
-    // model
-    glm::mat4 model =
-        glm::translate(glm::mat4(1.0f), glm::vec3(e.Position, 0.0f)) *
-        glm::scale(glm::mat4(1.0f), glm::vec3(e.Size, 1.0f));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgramTex, "model"), 1, GL_FALSE, glm::value_ptr(model));
+// queue any colored rectangle
+void drawRect(SpriteLayerId layer, glm::vec2 pos, glm::vec2 size, glm::vec3 color) {
+    spriteLayers[layer].instances.push_back({ glm::vec4(pos, size), glm::vec4(color, 1.f) });
+}
 
-    // bind texture
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, e.TexID);
-    glUniform1i(glGetUniformLocation(shaderProgramTex, "sprite"), 0);
+// queue a textured quad showing the atlas rect `uv`
+void drawTexturedSprite(SpriteLayerId layer, glm::vec2 pos, glm::vec2 size, const glm::vec4& uv) {
+    spriteLayers[layer].instances.push_back({ glm::vec4(pos, size), uv });
+}
 
-    // draw the quad
-    glBindVertexArray(texVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+// for enemies: TexID indexes enemySprites; drawn between the last two ticks.
+// A co-op host's asset pack may have more enemy sprites than ours.
+void drawTexturedEntity(const EntityStore& store, size_t i, float alpha) {
+    glm::vec2 pos = glm::mix(store.PrevPosition[i], store.Position[i], alpha);
+    unsigned int tex = store.TexID[i] < enemySprites.size() ? store.TexID[i] : 0;
+    drawTexturedSprite(LAYER_ACTORS, pos, store.Size[i], enemySprites[tex]);
 }
 
-// for soldier
-void drawTexturedSprite(glm::vec2 pos, glm::vec2 size, GLuint texID) {
-    glUseProgram(shaderProgramTex);
-    glm::mat4 proj = glm::ortho(0.f, (float)SCR_WIDTH, 0.f, (float)SCR_HEIGHT, -1.f, 1.f);
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgramTex, "projection"), 1, GL_FALSE, glm::value_ptr(proj));
-    glm::mat4 model = glm::translate(glm::mat4(1.f), glm::vec3(pos, 0.f))
-        * glm::scale(glm::mat4(1.f), glm::vec3(size, 1.f));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgramTex, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texID);
-    glUniform1i(glGetUniformLocation(shaderProgramTex, "sprite"), 0);
-    glBindVertexArray(texVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+// upload every queued instance in one go, then queue one draw per layer
+void flushSprites() {
+    PROFILE_SCOPE("sprites");
+    size_t layerBase[LAYER_COUNT], total = 0;
+    for (int i = 0; i < LAYER_COUNT; ++i) {
+        layerBase[i] = total;
+        total += spriteLayers[i].instances.size();
+    }
+    size_t base = 0;
+    SpriteInstance* dst = total ? (SpriteInstance*)streamVBO.map(total * sizeof(SpriteInstance), base) : nullptr;
+    if (!dst) {
+        for (SpriteLayer& l : spriteLayers) l.instances.clear();
+        return;
+    }
+    for (int i = 0; i < LAYER_COUNT; ++i)
+        std::copy(spriteLayers[i].instances.begin(), spriteLayers[i].instances.end(), dst + layerBase[i]);
+    streamVBO.unmap();
+    frameStats.bufferUploads++;
+
+    for (int i = 0; i < LAYER_COUNT; ++i) {
+        SpriteLayer& l = spriteLayers[i];
+        if (l.instances.empty()) continue;
+
+        DrawCommand c;
+        c.Layer = (uint8_t)(DRAW_SPRITES + i);
+        c.Program = l.textured ? spriteProgramTex : spriteProgram;
+        c.Vao = l.textured ? texVAO : VAO;
+        c.Texture = l.textured ? atlasTexture : 0;
+        c.Count = 6;
+        c.Instances = (GLsizei)l.instances.size();
+        c.Attribs = spriteAttribs;
+        c.StreamOffset = base + layerBase[i] * sizeof(SpriteInstance);
+        if (renderQueue.push(c)) {
+            frameStats.drawCalls++;
+            frameStats.instances += (unsigned int)l.instances.size();
+        }
+        l.instances.clear();
+    }
 }
 
 
 // input
-bool keys[1024];
-void keyCallback(GLFWwindow* w, int key, int scancode, int action, int mods) {
+bool keys[KEY_CODE_LIMIT];
+bool showProfiler = false;
+const int PROFILE_CAPTURE_FRAMES = 300;
+// simulation ticks per frame in a --fast replay (60 Hz worth)
+const int REPLAY_FRAME_TICKS = 2;
+void startRound();
+
+// Keys that affect the game are not acted on in the callback: they are
+// queued with the time they arrived and the simulation applies each one on
+// the tick whose slice of real time contains it, with its position inside
+// that tick (see applyInput). That makes them recordable and replayable
+// exactly, and ties firing to when the key went down, not to the frame.
+InputQueue inputQueue;
+// a Fire press during the tick being built, kept even if released again
+// before the tick runs, and how far into the tick it came
+bool  firePressed = false;
+float firePressedAt = 0.f;
+// Input latency, in gProfiler.nowUs() time: when the oldest key press not
+// yet simulated arrived, the one the running sim job applies, and the one
+// the frame being drawn is the first to show (-1 = none). The frame that
+// shows a press measures press -> glfwSwapBuffers.
+double keyPressedUs = -1, keyInSimUs = -1, keyOnScreenUs = -1;
+ReplayWriter recorder;
+ReplayReader replay;
+bool replaying = false;
+
+// gameplay side of a key event: held keys and menu transitions
+void handleKey(const KeyEvent& e) {
+    int key = e.Key, action = e.Action;
+    if (key == GLFW_KEY_SPACE && action == GLFW_PRESS && !keys[key] && !firePressed) {
+        firePressed = true;
+        firePressedAt = e.SubTick / 256.f;
+    }
     if (action == GLFW_PRESS)   keys[key] = true;
     if (action == GLFW_RELEASE) keys[key] = false;
+    // in co-op the host runs the menus and the rounds
+    if (netJoined) return;
 
     // state transitions
     if (key == GLFW_KEY_ENTER && action == GLFW_PRESS) {
         if (state == WELCOME || state == INSTRUCTIONS) {
             state = PLAYING;
+            startRound();
         }
         else if (state == GAME_OVER) {
             // reset
-            score = 0;
-            Player.Health = 100;
-            Enemies.clear();
-            Bullets.clear();
+            sim.resetRound();
             state = WELCOME;
         }
     }
@@ -233,314 +789,826 @@ void keyCallback(GLFWwindow* w, int key, int scancode, int action, int mods) {
     if (key == GLFW_KEY_BACKSPACE && action == GLFW_PRESS && state == INSTRUCTIONS) {
         state = WELCOME;
     }
+}
+
+void keyCallback(GLFWwindow* w, int key, int scancode, int action, int mods) {
+    if (key < 0 || key >= KEY_CODE_LIMIT) return;
+
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
         glfwSetWindowShouldClose(w, true);
     }
+
+    // profiling
+    if (key == GLFW_KEY_F3 && action == GLFW_PRESS) {
+        showProfiler = !showProfiler;
+    }
+    if (key == GLFW_KEY_F4 && action == GLFW_PRESS) {
+        gProfiler.startCapture(PROFILE_CAPTURE_FRAMES, "profile_trace.json");
+#ifndef NDEBUG
+        allocCheckSkip = true;
+#endif
+    }
+
+    // during a replay the recording is the only source of game input
+    // GLFW has no event timestamps, so this is when the poll delivered it
+    if (!replaying && (action == GLFW_PRESS || action == GLFW_RELEASE)) {
+        double now = gProfiler.nowUs();
+        inputQueue.push(InputEvent{ now, key, action });
+        if (action == GLFW_PRESS && keyPressedUs < 0) keyPressedUs = now;
+    }
 }
 
-void processInput() {
-    float v = 600.f * deltaTime;
-    // only vertical movement
-    if ((keys[GLFW_KEY_W] || keys[GLFW_KEY_UP]) && Player.Position.y + Player.Size.y < SCR_HEIGHT)
-        Player.Position.y += v;
+// apply the key events belonging to the tick about to run, which stands
+// for the real time (fromUs, toUs]; the game-over check follows, so
+// everything that changes the game happens on a tick
+void applyInput(double fromUs, double toUs) {
+    if (replaying) {
+        replay.replayTick(sim.Tick, [](const KeyEvent& e) { handleKey(e); });
+        return;
+    }
+    InputEvent ev;
+    while (inputQueue.popUntil(toUs, ev)) {
+        double f = toUs > fromUs ? (ev.TimeUs - fromUs) / (toUs - fromUs) : 0.0;
+        KeyEvent e{ sim.Tick, ev.Key, ev.Action, (uint8_t)std::min(std::max(f * 256.0, 0.0), 255.0) };
+        recorder.write(e);
+        handleKey(e);
+    }
+}
 
-    if ((keys[GLFW_KEY_S] || keys[GLFW_KEY_DOWN]) && Player.Position.y > 0)
-        Player.Position.y -= v;
+// what the current round's telemetry has counted but not logged yet
+struct RoundTally {
+    uint64_t StartTick = 0;
+    uint64_t LoggedTick = 0;   // of the last COMBAT record
+    uint32_t Shots = 0, Hits = 0, Misses = 0;
+    uint32_t Waves = 0;
+};
+RoundTally roundTally;
 
-    // shoot
-    if (keys[GLFW_KEY_SPACE]) {
-        ma_sound_start(&shootSound);  // plays shoot sound
-        static float lastShot = 0;
-        if (glfwGetTime() - lastShot >= 0.2f) {
-            Bullet b;
-            b.Position = Player.Position + glm::vec2(Player.Size.x, Player.Size.y / 2 - 5);
-            b.Velocity = glm::vec2(600.f, 0.f);
-            b.Color = glm::vec3(1.f, 0.8f, 0.2f);
-            Bullets.push_back(b);
-            lastShot = glfwGetTime();
-        }
+void logSimEvent(TelemetryType type, uint32_t v0 = 0, uint32_t v1 = 0, uint32_t v2 = 0, uint32_t v3 = 0);
+
+void logCombat() {
+    RoundTally& t = roundTally;
+    if (t.Shots || t.Hits || t.Misses) logSimEvent(TelemetryType::COMBAT, t.Shots, t.Hits, t.Misses);
+    t.Shots = t.Hits = t.Misses = 0;
+    t.LoggedTick = sim.Tick;
+}
+
+void startRound() {
+    roundTally = RoundTally();
+    roundTally.StartTick = roundTally.LoggedTick = sim.Tick;
+    logSimEvent(TelemetryType::ROUND_START);
+}
+
+// tally the tick that just ran; a wave firing closes the previous wave's
+// combat record, and otherwise one goes out every second
+void tallyTick() {
+    RoundTally& t = roundTally;
+    t.Shots += sim.ShotsFired;
+    t.Hits += (uint32_t)sim.Kills.size();
+    t.Misses += sim.ShotsMissed;
+    if (sim.wavesFired() != t.Waves) {
+        logCombat();
+        t.Waves = sim.wavesFired();
+        logSimEvent(TelemetryType::WAVE, t.Waves);
     }
+    else if (sim.Tick - t.LoggedTick >= (uint64_t)SIM_TICK_RATE) logCombat();
 }
 
-// high score I/O
-void loadHighScore() {
-    std::ifstream fin("highscore.txt");
-    if (fin) fin >> highScore;
+void checkGameOver() {
+    if (sim.Player.Health <= 0 && state == PLAYING) {
+        state = GAME_OVER;
+        highScore = std::max(highScore, sim.Score);
+        // the round's score goes into the log, which is the high-score
+        // table; a replay never opens the log, so it cannot touch it
+        logCombat();
+        uint64_t now = (uint64_t)time(NULL);
+        logSimEvent(TelemetryType::ROUND_END, sim.Score, (uint32_t)now, (uint32_t)(now >> 32),
+            (uint32_t)(sim.Tick - roundTally.StartTick));
+    }
 }
-void saveHighScore() {
-    std::ofstream fout("highscore.txt");
-    fout << highScore;
+
+// the held keys as the simulation sees them this tick
+SimInput processInput() {
+    SimInput in;
+    in.Up = keys[GLFW_KEY_W] || keys[GLFW_KEY_UP];
+    in.Down = keys[GLFW_KEY_S] || keys[GLFW_KEY_DOWN];
+    in.Fire = keys[GLFW_KEY_SPACE] || firePressed;
+    in.FireAt = firePressed ? firePressedAt : 0.f;
+    firePressed = false;
+    return in;
 }
 
-// spawn an enemy on the right, random Y
-void spawnEnemy() {
-    Enemy e;
-    e.Size = glm::vec2(100, 100);
-    e.Position = glm::vec2(SCR_WIDTH, rand() % (SCR_HEIGHT - (int)e.Size.y));
-    // negative ? moves left
-    e.Speed = -(150.f + rand() % 100);
-    e.TexID = enemyTextures[rand() % enemyTextures.size()];
-    Enemies.push_back(e);
+// Ticks run as a job: on a worker while the main thread renders the
+// previous frame, or inline with --threads 0. Everything they touch
+// (sim, keys, state, the recorder) is left alone by the main thread until
+// the job is waited on; inputQueue is the one thing shared while it runs.
+struct SimFrame {
+    int          Ticks = 0;
+    double       FromUs = 0, ToUs = 0;   // the real time the ticks stand for
+    unsigned int Shots = 0;   // fired during these ticks, for the sound
+    std::vector<glm::vec2> Kills;   // enemies shot down, for explosions
+    std::vector<TelemetryRecord> Telemetry;   // for the main thread to push
+    uint32_t     TelemetryDropped = 0;        // records that did not fit in it
+};
+SimFrame simFrame;
+
+// a full list drops the record, and counts it, as a full telemetry queue would
+void logSimEvent(TelemetryType type, uint32_t v0, uint32_t v1, uint32_t v2, uint32_t v3) {
+    if (!telemetryOn) return;
+    if (simFrame.Telemetry.size() == simFrame.Telemetry.capacity()) {
+        simFrame.TelemetryDropped++;
+        return;
+    }
+    TelemetryRecord r = {};
+    r.Type = type;
+    r.Tick = sim.Tick;
+    r.V[0] = v0;
+    r.V[1] = v1;
+    r.V[2] = v2;
+    r.V[3] = v3;
+    simFrame.Telemetry.push_back(r);
 }
 
-// text
-void renderText(const char* text, float x, float y, float scale, glm::vec3 color) {
-    static char buffer[99999];
-    int quads = stb_easy_font_print(0, 0, (char*)text, nullptr, buffer, sizeof(buffer));
+// main thread, with no sim job running
+void pushSimTelemetry() {
+    for (const TelemetryRecord& r : simFrame.Telemetry)
+        telemetry.push(r.Type, r.Tick, r.V[0], r.V[1], r.V[2], r.V[3]);
+    simFrame.Telemetry.clear();
+    telemetry.addDropped(simFrame.TelemetryDropped);
+    simFrame.TelemetryDropped = 0;
+}
 
-    // Convert each quad (4 vertices) into 2 triangles (6 vertices)
-    std::vector<float> vertices;
-    vertices.reserve(quads * 6 * 2); // 6 vertices per quad, 2 floats per vertex
+// --stress N: a scripted scene for render benchmarks that keeps N/2
+// enemies and N/2 bullets on screen and never ends. Driven only by the
+// seed, so the same seed draws the same frames.
+size_t stressEntities = 0;
+Rng stressRng;
+
+// enemy waves from --waves FILE, or the horde preset with --horde: the
+// standard load test, which also holds fire and keeps the player alive
+WaveSet waveSet;
+bool hordeMode = false;
+
+void topUpStress() {
+    while (sim.Enemies.size() < stressEntities / 2) {
+        size_t before = sim.Enemies.size();
+        sim.spawnEnemy();
+        if (sim.Enemies.size() == before) break;
+    }
+    while (sim.Bullets.size() < stressEntities / 2) {
+        glm::vec2 pos((float)stressRng.below((uint32_t)WORLD_WIDTH), (float)stressRng.below((uint32_t)WORLD_HEIGHT));
+        if (sim.Bullets.create(pos, glm::vec2(600.f, 0.f), glm::vec2(10, 4)).Slot == UINT32_MAX) break;
+    }
+}
 
-    for (int i = 0; i < quads; ++i) {
-        float* quad = (float*)(buffer + i * 4 * 16); // 4 vertices * 16 bytes each
+void runSimFrame(void*, size_t, size_t) {
+    PROFILE_SCOPE("simulate");
+    double span = (simFrame.ToUs - simFrame.FromUs) / simFrame.Ticks;
+    for (int t = 0; t < simFrame.Ticks; ++t) {
+        // the last tick takes everything up to the poll, rounding or not
+        double tickTo = t + 1 == simFrame.Ticks ? simFrame.ToUs : simFrame.FromUs + span * (t + 1);
+        applyInput(simFrame.FromUs + span * t, tickTo);
+        SimInput in = processInput();
+        if (netJoined) {
+            netClient.tick(in);
+            continue;
+        }
+        if (stressEntities) topUpStress();
+        if (stressEntities || hordeMode) in.Fire = true;
+        SimInput partner[NetHost::MAX_INPUTS_PER_TICK];
+        size_t partnerCount = netHost.takeInputs(partner, NetHost::MAX_INPUTS_PER_TICK);
+        sim.step(in, state == PLAYING, partner, partnerCount);
+        if (stressEntities || hordeMode) sim.Player.Health = 100.f;
+        simFrame.Shots += sim.ShotsFired;
+        for (size_t k = 0; k < sim.Kills.size() && simFrame.Kills.size() < simFrame.Kills.capacity(); ++k)
+            simFrame.Kills.push_back(sim.Kills[k]);
+        if (telemetryOn && state == PLAYING) tallyTick();
+        checkGameOver();
+    }
+}
 
-        // Extract 4 vertices
-        glm::vec2 v0 = { quad[0], quad[1] };
-        glm::vec2 v1 = { quad[4], quad[5] };
-        glm::vec2 v2 = { quad[8], quad[9] };
-        glm::vec2 v3 = { quad[12], quad[13] };
+// What the renderer draws, copied out of the simulation between sim jobs
+// so drawing never reads state that is being stepped.
+struct FrameSnapshot {
+    GameState    State = WELCOME;
+    unsigned int Score = 0;
+    unsigned int HighScore = 0;
+    uint64_t     Tick = 0;
+    float        Alpha = 0.f;
+    Entity       Player;
+    glm::vec2    PrevPlayerPosition;
+    bool         Coop = false;   // draw Partner too
+    Entity       Partner;
+    glm::vec2    PrevPartnerPosition;
+    EntityStore  Bullets;
+    EntityStore  Enemies;
+};
+FrameSnapshot view;
+
+// A client draws its own ship where it predicts it, and everything else
+// as the host had it a little while ago (see NetClient).
+void takeClientSnapshot(float alpha) {
+    view.State = state;
+    view.Score = netClient.score();
+    view.HighScore = highScore;
+    view.Tick = netClient.ticks();
+    view.Alpha = alpha;
+    view.Player = sim.Player;
+    view.Player.Health = (float)netClient.health();
+    netClient.interpolate(gProfiler.nowUs() / 1000.0, view.Player.Position, view.Enemies, view.Bullets);
+    view.PrevPlayerPosition = view.Player.Position;
+    view.Coop = true;
+    view.Partner = netClient.ship();
+    view.PrevPartnerPosition = netClient.prevShipPosition();
+}
 
-        // Triangle 1: v0, v1, v2
-        vertices.push_back(v0.x); vertices.push_back(v0.y);
-        vertices.push_back(v1.x); vertices.push_back(v1.y);
-        vertices.push_back(v2.x); vertices.push_back(v2.y);
+void takeSnapshot(float alpha) {
+    PROFILE_SCOPE("snapshot");
+    if (netJoined) {
+        takeClientSnapshot(alpha);
+        return;
+    }
+    view.State = state;
+    view.Score = sim.Score;
+    view.HighScore = highScore;
+    view.Tick = sim.Tick;
+    view.Alpha = alpha;
+    view.Player = sim.Player;
+    view.PrevPlayerPosition = sim.PrevPlayerPosition;
+    view.Coop = netHost.connected();
+    view.Partner = sim.Partner;
+    view.PrevPartnerPosition = sim.PrevPartnerPosition;
+    // same capacity as the sim's pools, so these copies never reallocate
+    view.Bullets = sim.Bullets;
+    view.Enemies = sim.Enemies;
+}
 
-        // Triangle 2: v0, v2, v3
-        vertices.push_back(v0.x); vertices.push_back(v0.y);
-        vertices.push_back(v2.x); vertices.push_back(v2.y);
-        vertices.push_back(v3.x); vertices.push_back(v3.y);
+// map the asset pack and upload its atlas, every mip level as baked;
+// enemies are the sprites "enemy1", "enemy2", ... in that order
+bool loadAssets(const char* path) {
+    if (!assets.open(path)) return false;
+    const PackHeader& h = assets.header();
+
+    glGenTextures(1, &atlasTexture);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)h.MipCount - 1);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (uint32_t l = 0; l < h.MipCount; ++l) {
+        const PackMip& m = assets.mip(l);
+        glTexImage2D(GL_TEXTURE_2D, (GLint)l, GL_RGBA8, (GLsizei)m.Width, (GLsizei)m.Height, 0,
+            GL_RGBA, GL_UNSIGNED_BYTE, assets.data(m.Offset));
     }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    auto uvRect = [](const PackSprite& s) { return glm::vec4(s.U0, s.V0, s.U1 - s.U0, s.V1 - s.V0); };
+    char name[32];
+    for (int i = 1; ; ++i) {
+        snprintf(name, sizeof(name), "enemy%d", i);
+        const PackSprite* s = assets.findSprite(name);
+        if (!s) break;
+        enemySprites.push_back(uvRect(*s));
+    }
+    const PackSprite* player = assets.findSprite("player");
+    if (enemySprites.empty() || !player) {
+        std::cerr << path << " needs the sprites player and enemy1\n";
+        return false;
+    }
+    playerSprite = uvRect(*player);
+    return true;
+}
 
-    // Set up projection
-    glm::mat4 proj = glm::ortho(0.f, (float)SCR_WIDTH, 0.f, (float)SCR_HEIGHT);
-    glUseProgram(shaderProgram);
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(proj));
-    glUniform3fv(glGetUniformLocation(shaderProgram, "color"), 1, glm::value_ptr(color));
+// The best score in the telemetry log, or in highscore.txt from older
+// builds, which is still read but no longer written. `repair` truncates
+// what a crash left half-written, so the log can be appended to; false
+// when the log could not be read or repaired and must not be appended to.
+bool loadHighScore(const char* logPath, bool repair) {
+    std::ifstream fin("highscore.txt");
+    if (fin) fin >> highScore;
 
-    // Upload vertex data
-    GLuint VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
+    TelemetryScan scan;
+    std::string error;
+    bool ok = repair ? TelemetryLog::recover(logPath, scan, error) : TelemetryLog::scan(logPath, scan, error);
+    if (!ok) {
+        std::cerr << error << "\n";
+        return false;
+    }
+    if (repair && scan.TornBytes)
+        std::cout << "telemetry: " << logPath << " was cut short by a crash, dropped the last " << scan.TornBytes << " bytes\n";
+    if (scan.Corrupt)
+        std::cout << "telemetry: skipped " << scan.Corrupt << " damaged records in " << logPath << "\n";
+    if (!scan.HighScores.empty()) highScore = std::max(highScore, scan.HighScores[0].Score);
+    return true;
+}
 
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+// text
+struct TextInstance {
+    glm::vec4 Rect;    // position.xy, size.xy
+    glm::vec4 UV;      // glyph uv offset.xy, uv scale.zw
+    glm::vec3 Color;
+};
 
-    // Apply model transform
-    glm::mat4 model = glm::translate(glm::mat4(1.0f), { x, SCR_HEIGHT - y, 0.0f })
-        * glm::scale(glm::mat4(1.0f), { scale, -scale, 1.0f });
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-
-    // Draw all triangles
-    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(vertices.size() / 2));
-
-    // Cleanup
-    glDeleteBuffers(1, &VBO);
-    glDeleteVertexArrays(1, &VAO);
-}
-
-int main() {
-    srand((unsigned)time(NULL));
-    // init GLFW
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "ZapValks", NULL, NULL);
-    glfwMakeContextCurrent(window);
-    glfwSetKeyCallback(window, keyCallback);
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD\n";
-        return -1;
+// text queued this frame: one run of glyph instances per string, in frameArena
+struct TextChunk {
+    const TextInstance* Glyphs;
+    size_t              Count;
+};
+const int MAX_TEXT_CHUNKS = 256;
+const size_t MAX_TEXT_GLYPHS = 256;   // per string
+TextChunk textChunks[MAX_TEXT_CHUNKS];
+int    textChunkCount = 0;
+size_t textFrameGlyphCount = 0;
+GlyphQuad textScratch[MAX_TEXT_GLYPHS];
+
+void renderText(const char* text, float x, float y, float scale, glm::vec3 color) {
+    size_t count = glyphAtlas.layout(text, scale, textScratch, MAX_TEXT_GLYPHS);
+    TextInstance* dst = count && textChunkCount < MAX_TEXT_CHUNKS ? frameArena.alloc<TextInstance>(count) : nullptr;
+    if (!dst) return;
+    textChunks[textChunkCount++] = TextChunk{ dst, count };
+    textFrameGlyphCount += count;
+
+    // place at (x, y) from the top-left of the screen; the layout's y axis points down
+    for (size_t i = 0; i < count; ++i) {
+        const GlyphQuad& q = textScratch[i];
+        dst[i].Rect = glm::vec4(x + q.X, WORLD_HEIGHT - y - q.Y - q.H, q.W, q.H);
+        dst[i].UV = glm::vec4(q.U, q.V, q.UW, q.VH);
+        dst[i].Color = color;
     }
-    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
-
-    initRenderer();
-
-    // Enemy textures
-    auto loadTexture = [&](const char* path) {
-        int w, h, chan;
-        stbi_set_flip_vertically_on_load(true);
-        unsigned char* data = stbi_load(path, &w, &h, &chan, STBI_rgb_alpha);
-        if (!data) { std::cerr << "Failed to load " << path << "\n"; return 0u; }
-        GLuint tex; glGenTextures(1, &tex);
-        glBindTexture(GL_TEXTURE_2D, tex);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        stbi_image_free(data);
-        return tex;
-        };
-
-    // load enemy PNGs
-    enemyTextures.push_back(loadTexture("D:/Shooter game assets/Valkyrie 1.png"));
-    enemyTextures.push_back(loadTexture("D:/Shooter game assets/Valkyrie 2.png"));
-    enemyTextures.push_back(loadTexture("D:/Shooter game assets/Valkyrie 3.png"));
-
-    // load player PNGs
-    playerTextures.push_back(loadTexture("D:/Shooter game assets/soldier.png"));
-
-    // compile a second shader that samples a texture:
-    const char* vsTex = R"(
-#version 330 core
-layout(location=0) in vec2 aPos;
-layout(location=1) in vec2 aTex;
-uniform mat4 projection, model;
-out vec2 TexCoord;
-void main(){
-    TexCoord = aTex;
-    gl_Position = projection * model * vec4(aPos,0,1);
 }
-)";
-    const char* fsTex = R"(
-#version 330 core
-in vec2 TexCoord;
-out vec4 FragColor;
-uniform sampler2D sprite;
-void main(){
-    FragColor = texture(sprite, TexCoord);
+
+void textAttribs(size_t base) {
+    glBindBuffer(GL_ARRAY_BUFFER, streamVBO.buffer());
+    GLsizei stride = sizeof(TextInstance);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(TextInstance, Rect)));
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(TextInstance, UV)));
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(TextInstance, Color)));
 }
-)";
-    shaderProgramTex = createProgram(vsTex, fsTex);
 
-    // setup a VAO/VBO for textured quads (pos + uv)
-    float quadData[] = {
-        // pos      // uv
-         0,1,       0,1,
-         1,0,       1,0,
-         0,0,       0,0,
-         0,1,       0,1,
-         1,1,       1,1,
-         1,0,       1,0
-    };
-    glGenVertexArrays(1, &texVAO);
-    glGenBuffers(1, &texVBO);
-    glBindVertexArray(texVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, texVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quadData), quadData, GL_STATIC_DRAW);
-    // pos attr
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-    // uv attr
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-    glBindVertexArray(0);
+// gather all text queued this frame into the stream buffer as one draw
+void flushText() {
+    PROFILE_SCOPE("text");
+    if (textFrameGlyphCount == 0) return;
+    size_t glyphs = textFrameGlyphCount;
+    size_t base = 0;
+    TextInstance* dst = (TextInstance*)streamVBO.map(glyphs * sizeof(TextInstance), base);
+    if (dst) {
+        for (int i = 0; i < textChunkCount; ++i) {
+            memcpy(dst, textChunks[i].Glyphs, textChunks[i].Count * sizeof(TextInstance));
+            dst += textChunks[i].Count;
+        }
+        streamVBO.unmap();
+    }
+    textChunkCount = 0;
+    textFrameGlyphCount = 0;
+    if (!dst) return;
+
+    frameStats.bufferUploads++;
+    DrawCommand c;
+    c.Layer = DRAW_TEXT;
+    c.Program = textProgram;
+    c.Vao = textVAO;
+    c.Texture = fontTexture;
+    c.Count = 6;
+    c.Instances = (GLsizei)glyphs;
+    c.Attribs = textAttribs;
+    c.StreamOffset = base;
+    if (renderQueue.push(c)) {
+        frameStats.drawCalls++;
+        frameStats.glyphs += (unsigned int)glyphs;
+    }
+}
+
+// profiler overlay (F3): averaged CPU/GPU ms per zone and last frame's counters
+void drawProfilerOverlay() {
+    char line[128];
+    float y = 20.f;
+    sprintf_s(line, "frame %6.2f ms", gProfiler.frameMs());
+    renderText(line, 1450.f, y, 2.f, glm::vec3(1.f, 1.f, 0.4f));
+    static std::vector<Profiler::ZoneStat> zones;
+    gProfiler.copyZones(zones);
+    for (const Profiler::ZoneStat& z : zones) {
+        y += 22.f;
+        sprintf_s(line, "%*s%-12s cpu %6.3f  gpu %6.3f", z.Depth * 2, "", z.Name, z.CpuMs, z.GpuMs);
+        renderText(line, 1450.f, y, 2.f, glm::vec3(0.8f, 1.f, 0.8f));
+    }
+    for (const Profiler::CounterStat& c : gProfiler.counters()) {
+        y += 22.f;
+        sprintf_s(line, "%-16s %8.0f", c.Name, c.Value);
+        renderText(line, 1450.f, y, 2.f, glm::vec3(0.7f, 0.8f, 1.f));
+    }
+}
+
+int main(int argc, char** argv) {
+    // --seed N replays the exact same game; otherwise every run differs
+    uint64_t seed = (uint64_t)time(NULL);
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    const char* histogramPath = nullptr;
+    bool fastReplay = false;
+    PacingMode pacingMode = PacingMode::VSYNC;
+    double targetFps = 0;
+    bool pacingSet = false;
+    int starDensity = 150;
+    const char* assetsPath = "assets.zvpk";
+    const char* wavesPath = nullptr;
+    const char* telemetryPath = "telemetry.zvtl";
+    bool telemetrySet = false;
+    // co-op: host on a UDP port (0 = any free one), or join one
+    int hostPort = -1;
+    const char* joinAddress = nullptr;
+    int netRate = NET_DEFAULT_RATE;
+    size_t particleCapacity = 1 << 20;
+    // --headless renders `frameLimit` frames into an offscreen target instead of a window
+    bool headless = false;
+    int targetWidth = SCR_WIDTH, targetHeight = SCR_HEIGHT;
+    int frameLimit = 600;
+    const char* captureDir = nullptr;
+    const char* goldenDir = nullptr;
+    // --render-scale fixes the scene resolution; --gpu-budget lets it follow
+    // the GPU frame time (on by default with a window)
+    float renderScale = 1.f;
+    bool fixedScale = false;
+    DynamicResolutionConfig dynamicResConfig;
+    bool budgetSet = false;
+    // workers besides the main thread; 0 runs everything on one thread, unpipelined
+    int threadCount = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--seed") == 0 && hasValue) seed = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--record") == 0 && hasValue) recordPath = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && hasValue) replayPath = argv[++i];
+        else if (strcmp(argv[i], "--histogram") == 0 && hasValue) histogramPath = argv[++i];
+        else if (strcmp(argv[i], "--fast") == 0) fastReplay = true;
+        else if (strcmp(argv[i], "--pacing") == 0 && hasValue) {
+            if (!FramePacer::parseMode(argv[++i], pacingMode)) std::cerr << "Unknown pacing mode " << argv[i] << "\n";
+            pacingSet = true;
+        }
+        else if (strcmp(argv[i], "--fps") == 0 && hasValue) {
+            targetFps = atof(argv[++i]);
+            pacingMode = PacingMode::CAPPED;
+            pacingSet = true;
+        }
+        else if (strcmp(argv[i], "--stars") == 0 && hasValue) starDensity = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue) threadCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--assets") == 0 && hasValue) assetsPath = argv[++i];
+        else if (strcmp(argv[i], "--particles") == 0 && hasValue) particleCapacity = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--headless") == 0) headless = true;
+        else if (strcmp(argv[i], "--size") == 0 && hasValue) sscanf(argv[++i], "%dx%d", &targetWidth, &targetHeight);
+        else if (strcmp(argv[i], "--frames") == 0 && hasValue) frameLimit = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--capture") == 0 && hasValue) captureDir = argv[++i];
+        else if (strcmp(argv[i], "--golden") == 0 && hasValue) goldenDir = argv[++i];
+        else if (strcmp(argv[i], "--stress") == 0 && hasValue) stressEntities = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--waves") == 0 && hasValue) wavesPath = argv[++i];
+        else if (strcmp(argv[i], "--horde") == 0) hordeMode = true;
+        else if (strcmp(argv[i], "--telemetry") == 0 && hasValue) { telemetryPath = argv[++i]; telemetrySet = true; }
+        else if (strcmp(argv[i], "--host") == 0 && hasValue) hostPort = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--join") == 0 && hasValue) joinAddress = argv[++i];
+        else if (strcmp(argv[i], "--net-rate") == 0 && hasValue) netRate = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--render-scale") == 0 && hasValue) { renderScale = (float)atof(argv[++i]); fixedScale = true; }
+        else if (strcmp(argv[i], "--gpu-budget") == 0 && hasValue) { dynamicResConfig.BudgetMs = (float)atof(argv[++i]); budgetSet = true; }
+    }
+
+    if (hostPort > 65535) {
+        std::cerr << "--host needs a port number (0 to 65535)\n";
+        return -1;
+    }
+    // a recording holds one player's keys; the partner's arrive over the network
+    if ((hostPort >= 0 || joinAddress) && (replayPath || recordPath)) {
+        std::cerr << "--record and --replay do not work in co-op\n";
+        return -1;
+    }
+    if (hostPort >= 0 && joinAddress) {
+        std::cerr << "--host and --join are two different ends of a game; pick one\n";
+        return -1;
+    }
+    if (joinAddress && (stressEntities || hordeMode || wavesPath)) {
+        std::cerr << "--stress, --waves and --horde are the host's to choose; ignored\n";
+        stressEntities = 0;
+        hordeMode = false;
+        wavesPath = nullptr;
+    }
 
+    if (replayPath) {
+        if (!replay.load(replayPath) || replay.TickRate != (unsigned int)SIM_TICK_RATE) {
+            std::cerr << "Failed to load replay " << replayPath << "\n";
+            return -1;
+        }
+        replaying = true;
+        seed = replay.Seed;
+    }
+    else if (recordPath && !recorder.open(recordPath, seed, (unsigned int)SIM_TICK_RATE)) {
+        std::cerr << "Failed to open " << recordPath << " for recording\n";
+    }
+    std::cout << "seed: " << seed << "\n";
+
+    if (hordeMode) waveSet = WaveSet::horde();
+    else if (wavesPath) {
+        std::string error;
+        if (!waveSet.load(wavesPath, error)) {
+            std::cerr << error << "\n";
+            return -1;
+        }
+    }
+    if (!waveSet.Waves.empty())
+        std::cout << "waves: " << (hordeMode ? "horde" : wavesPath) << ", " << waveSet.Waves.size() << " defined"
+            << (waveSet.LoopFrom >= 0 ? ", looping\n" : "\n");
+
+    // init GLFW, or a windowless context drawing into an FBO
+    GLFWwindow* window = nullptr;
+    HeadlessContext headlessContext;
+    RenderTarget offscreen;
+    GLADloadproc getProc = (GLADloadproc)glfwGetProcAddress;
+    if (headless) {
+        if (!headlessContext.init()) return -1;
+        getProc = (GLADloadproc)HeadlessContext::getProcAddress;
+    }
+    else {
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "ZapValks", NULL, NULL);
+        glfwMakeContextCurrent(window);
+        glfwSetKeyCallback(window, keyCallback);
+    }
+
+    // a fast replay measures the game, not the display's refresh rate, and
+    // a headless run has no display to wait for
+    if ((replaying && fastReplay) || (headless && !pacingSet)) pacingMode = PacingMode::UNCAPPED;
+    FramePacer pacer;
+    bool tearControl = !headless && (glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+        glfwExtensionSupported("GLX_EXT_swap_control_tear"));
+    pacer.init(pacingMode, targetFps, tearControl);
+    if (!headless) glfwSwapInterval(pacer.swapInterval());
+    std::cout << "pacing: " << FramePacer::modeName(pacer.mode());
+    if (pacer.mode() == PacingMode::CAPPED) std::cout << " at " << targetFps << " fps";
+    std::cout << "\n";
+    if (!gladLoadGLLoader(getProc)) {
+        std::cerr << "Failed to initialize GLAD\n";
+        return -1;
+    }
+    if (headless) {
+        // the world stays 1920x1080; the viewport scales it to the target
+        if (!offscreen.create(targetWidth, targetHeight)) return -1;
+        offscreen.bind();
+        std::cout << "headless: " << targetWidth << "x" << targetHeight << ", " << frameLimit << " frames, "
+            << glGetString(GL_RENDERER) << "\n";
+    }
 
-    // init player on left
-    Player.Position = glm::vec2(20, SCR_HEIGHT / 2 - 25);
-    Player.Size = glm::vec2(80, 80);
-    Player.Color = glm::vec3(0.2f, 0.6f, 1.f);
-    Player.Health = 100.f;
+    // a headless run keeps a fixed scale unless asked, so captures repeat
+    bool adaptiveRes = !fixedScale && (budgetSet || !headless);
+    dynamicRes.init(dynamicResConfig, adaptiveRes, renderScale);
+    std::cout << "render scale: " << (adaptiveRes ? "dynamic, budget " : "fixed ")
+        << (adaptiveRes ? dynamicResConfig.BudgetMs : renderScale) << (adaptiveRes ? " ms\n" : "\n");
 
-    // assign player texture
-    GLuint playerTexID = playerTextures[0];
+    initRenderer(getProc);
+    initStarfield(starDensity, seed);
+    initGpuTimers();
 
-    // build starfield
-    for (int i = 0; i < 150; i++) {
-        Stars.emplace_back(
-            (float)(rand() % SCR_WIDTH),
-            (float)(rand() % SCR_HEIGHT)
-        );
+    if (!loadAssets(assetsPath)) {
+        if (!headless) glfwTerminate();
+        return -1;
     }
 
-    loadHighScore();
-    float spawnTimer = 0.f;
+    SimConfig simConfig;
+    simConfig.EnemyTextures = (unsigned int)enemySprites.size();
+    if (stressEntities) {
+        simConfig.MaxBullets = std::max(simConfig.MaxBullets, stressEntities);
+        simConfig.MaxEnemies = std::max(simConfig.MaxEnemies, stressEntities / 2);
+        stressRng.reseed(seed);
+        state = PLAYING;
+    }
+    if (!waveSet.Waves.empty()) {
+        simConfig.Waves = &waveSet;
+        simConfig.MaxEnemies = std::max(simConfig.MaxEnemies, waveSet.MaxEnemies);
+        if (hordeMode) state = PLAYING;
+    }
+    simConfig.Coop = hostPort >= 0;
+    // whatever the host sends; the client's own sim is never stepped
+    if (joinAddress) simConfig.MaxEnemies = simConfig.MaxBullets = NET_MAX_ENTITIES;
+    sim = Simulation(seed, simConfig);
+    reserveSprites(simConfig);
+    view.Bullets.setCapacity(simConfig.MaxBullets);
+    view.Enemies.setCapacity(simConfig.MaxEnemies);
+    particles.setCapacity(particleCapacity);
+    simFrame.Kills.reserve(simConfig.MaxEnemies);
+    simFrame.Telemetry.reserve(64);
+
+    JobSystem jobs(threadCount);
+    sim.setJobs(&jobs);
+    bool pipelined = jobs.workerCount() > 0;
+    JobCounter simJob;
+    std::cout << "threads: " << jobs.workerCount() << " workers" << (pipelined ? ", pipelined\n" : "\n");
+
+    if (hostPort >= 0 && !netHost.open((uint16_t)hostPort, netRate, simConfig)) {
+        if (!headless) glfwTerminate();
+        return -1;
+    }
+    if (joinAddress) {
+        if (!netClient.open(joinAddress)) {
+            if (!headless) glfwTerminate();
+            return -1;
+        }
+        netJoined = true;
+    }
 
-    if (ma_engine_init(NULL, &engine) != MA_SUCCESS) {
-        std::cerr << "Failed to initialize MiniAudio engine.\n";
+    // a replay or a headless run is a measurement, not a session, and a
+    // co-op client's rounds are the host's; only an explicit --telemetry
+    // logs them
+    bool wantTelemetry = telemetrySet || (!replaying && !headless && !netJoined);
+    // appending past a torn tail, or to someone else's file, would bury
+    // the log; leave it for a look and log nothing this session
+    if (!loadHighScore(telemetryPath, wantTelemetry) && wantTelemetry) {
+        std::cerr << "telemetry: not logging this session, " << telemetryPath << " is left as it is\n";
+        wantTelemetry = false;
     }
-    if (ma_sound_init_from_file(&engine, "D:/Shooter game assets/shoot_sound.mp3", 0, NULL, NULL, &shootSound) != MA_SUCCESS) {
-        std::cerr << "Failed to load shoot.wav\n";
+    if (wantTelemetry && telemetry.open(telemetryPath)) {
+        telemetryOn = true;
+        uint64_t now = (uint64_t)time(NULL);
+        telemetry.push(TelemetryType::SESSION_START, 0, (uint32_t)seed, (uint32_t)(seed >> 32), (uint32_t)now, (uint32_t)(now >> 32));
+        if (state == PLAYING) startRound();
     }
 
+    // shots can overlap at the fire rate, so give the sound a few voices;
+    // headless runs on machines without an audio device and stay silent
+    const PackSound* shoot = assets.findSound("shoot");
+    if (!headless && audio.init() && shoot)
+        shootSound = audio.loadPcm(assets.data(shoot->Offset), shoot->Frames, shoot->Channels, shoot->SampleRate, 6);
+
+    // frame times of the whole run, printed on exit (and saved with --histogram)
+    FrameHistogram frameTimes;
+    FrameHistogram inputLatency;
+    // the current telemetry window
+    FrameHistogram windowTimes;
+    float windowTimer = 0.f;
+    // fence after each swap; with vsync the next frame waits on it so the
+    // driver never queues more than one frame ahead of the display
+    GLsync lastSwapFence = nullptr;
+#ifndef NDEBUG
+    int playingFrames = 0;
+#endif
+
+    // once a second the draw-call/instance counts of the last frame go to the title bar
+    float statsTimer = 0.f;
+    char titleStr[128];
+
+    // readbacks of the offscreen target, written out and/or checked
+    FrameCapture capture;
+    bool capturing = headless && (captureDir || goldenDir);
+    if (capturing) capture.init(targetWidth, targetHeight, captureDir, goldenDir, &jobs);
+    int frameIndex = 0;
+    bool quit = false;
+    double inputSinceUs = gProfiler.nowUs();
+
     // game loop
-    while (!glfwWindowShouldClose(window)) {
-        // time
-        float now = glfwGetTime();
-        deltaTime = now - lastFrame;
-        lastFrame = now;
-
-        glfwPollEvents();
-        processInput();
-
-        // spawn
-        spawnTimer += deltaTime;
-        if (state == PLAYING && spawnTimer >= 0.5f) {
-            spawnEnemy();
-            spawnTimer = 0;
-        }
-
-        // update bullets
-        for (auto& b : Bullets)
-            b.Position += b.Velocity * deltaTime;
-        Bullets.erase(
-            std::remove_if(Bullets.begin(), Bullets.end(),
-                [](auto& b) { return b.Position.x > SCR_WIDTH + 10; }),
-            Bullets.end()
-        );
-
-        // update enemies & collisions
-        for (auto eIt = Enemies.begin(); eIt != Enemies.end(); ) {
-            eIt->Position.x += eIt->Speed * deltaTime;
-            bool removed = false;
-            // off-screen left
-            if (eIt->Position.x + eIt->Size.x < 0) {
-                Player.Health -= 20.f;
-                eIt = Enemies.erase(eIt);
-                removed = true;
-            }
-            else {
-                // bullet collisions
-                for (auto bIt = Bullets.begin(); bIt != Bullets.end(); ) {
-                    if (bIt->Position.x > eIt->Position.x &&
-                        bIt->Position.x < eIt->Position.x + eIt->Size.x &&
-                        bIt->Position.y > eIt->Position.y &&
-                        bIt->Position.y < eIt->Position.y + eIt->Size.y)
-                    {
-                        score += 10;
-                        bIt = Bullets.erase(bIt);
-                        eIt = Enemies.erase(eIt);
-                        removed = true;
-                        break;
-                    }
-                    else ++bIt;
-                }
-            }
-            if (!removed) ++eIt;
+    while (!quit && (headless ? frameIndex < frameLimit : !glfwWindowShouldClose(window))) {
+        // pace first, so input is read after the wait and not before it
+        double paceMs = pacer.wait();
+        if (lastSwapFence) {
+            auto start = std::chrono::steady_clock::now();
+            glClientWaitSync(lastSwapFence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000);   // 100 ms
+            glDeleteSync(lastSwapFence);
+            lastSwapFence = nullptr;
+            paceMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
         }
 
-
-        if (Player.Health <= 0 && state == PLAYING) {
-            state = GAME_OVER;
-            if (score > highScore) {
-                highScore = score;
-                saveHighScore();
+        // time; headless frames are exactly one tick apart so runs repeat
+        if (headless) deltaTime = SIM_DT;
+        else {
+            float now = glfwGetTime();
+            deltaTime = now - lastFrame;
+            lastFrame = now;
+        }
+        gProfiler.beginFrame();
+        nextGpuTimerFrame();
+        frameArena.reset();
+        streamVBO.beginFrame();
+#ifndef NDEBUG
+        uint64_t allocsAtFrameStart = heapAllocs.load();
+#endif
+
+        // last frame's ticks must be done before input and the snapshot
+        {
+            PROFILE_SCOPE("waitSim");
+            jobs.wait(simJob);
+        }
+        pushSimTelemetry();
+        // co-op traffic, between sim jobs: the host reads the partner's
+        // inputs and sends what the last ticks left; the client takes in
+        // snapshots and follows the host's game state
+        {
+            PROFILE_SCOPE("net");
+            double netMs = gProfiler.nowUs() / 1000.0;
+            netHost.update(sim, (uint8_t)state, netMs);
+            if (netJoined) {
+                netClient.update(netMs);
+                state = (GameState)std::min<int>(netClient.phase(), GAME_OVER);
+                for (size_t k = 0; k < netClient.Kills.size() && simFrame.Kills.size() < simFrame.Kills.capacity(); ++k)
+                    simFrame.Kills.push_back(netClient.Kills[k]);
+                netClient.Kills.clear();
+                simFrame.Shots += netClient.Shots;
+                netClient.Shots = 0;
+                // the host ended the game or turned us away
+                if (!netClient.isOpen()) quit = true;
             }
         }
+        for (; simFrame.Shots > 0; --simFrame.Shots)
+            audio.play(shootSound);
+        // particles follow the ticks that just finished, which is also
+        // the state this frame draws, and run before the next sim job is
+        // queued so they have the workers to themselves
+        for (const glm::vec2& k : simFrame.Kills)
+            emitExplosion(k);
+        simFrame.Kills.clear();
+        if (state == PLAYING) emitTrail(netJoined ? netClient.ship() : sim.Player, deltaTime, PLAYER_TRAIL_RATE);
+        particles.update(deltaTime, &jobs);
+        if (replaying && replay.finished(sim.Tick)) {
+            quit = true;
+        }
+
+        if (!headless) {
+            PROFILE_SCOPE("pollEvents");
+            glfwPollEvents();
+        }
+        double polledUs = gProfiler.nowUs();
+
+        // run as many fixed ticks as real time has covered; a long hitch
+        // is clamped instead of being caught up all at once. A fast replay
+        // ignores the clock and runs a 60 Hz frame's worth per frame.
+        float alpha = simAccumulator / SIM_DT;
+        if (replaying && fastReplay) simAccumulator += REPLAY_FRAME_TICKS * SIM_DT;
+        else simAccumulator += std::min(deltaTime, 0.25f);
+        simFrame.Ticks = (int)(simAccumulator / SIM_DT);
+        simAccumulator -= simFrame.Ticks * SIM_DT;
+
+        // Pipelined, this frame draws the state the last frame's ticks
+        // produced while a worker runs this frame's ticks, at the cost of
+        // one frame of latency. Unpipelined, the ticks run first.
+        // this frame's ticks stand for the time since the last frame that
+        // ran any; with none, queued input waits for the next one
+        double keysThisFrame = -1;
+        if (simFrame.Ticks > 0) {
+            simFrame.FromUs = inputSinceUs;
+            simFrame.ToUs = polledUs;
+            inputSinceUs = polledUs;
+            keysThisFrame = keyPressedUs;
+            keyPressedUs = -1;
+        }
+        if (pipelined) {
+            takeSnapshot(alpha);
+            keyOnScreenUs = keyInSimUs;
+            keyInSimUs = keysThisFrame;
+            jobs.submit(simJob, runSimFrame, nullptr);
+        }
+        else {
+            runSimFrame(nullptr, 0, 0);
+            takeSnapshot(simAccumulator / SIM_DT);
+            keyOnScreenUs = keysThisFrame;
+        }
+        alpha = view.Alpha;
 
         // ** RENDER **
+        gProfiler.beginZone("render");
+        dynamicRes.beginFrame();
+        renderQueue.beginFrame(glm::ortho(0.f, WORLD_WIDTH, 0.f, WORLD_HEIGHT, -1.f, 1.f));
+        // the scene target follows the output size; the scale only picks
+        // how much of it this frame draws into
+        int outW = targetWidth, outH = targetHeight;
+        if (!headless) glfwGetFramebufferSize(window, &outW, &outH);
+        if (outW > 0 && outH > 0 && (sceneTarget.width() != outW || sceneTarget.height() != outH))
+            sceneTarget.create(outW, outH);
+        int sceneW, sceneH;
+        dynamicRes.drawSize(outW, outH, sceneW, sceneH);
+        sceneTarget.bind();
+        glViewport(0, 0, sceneW, sceneH);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        if (state == WELCOME) {
+        // starfield, shared by every screen
+        drawStarfield((float)((view.Tick + alpha) * SIM_DT));
+
+        if (view.State == WELCOME) {
             glClearColor(0.05f, 0.05f, 0.2f, 1.f);
 
-            // starfield
-            for (auto& s : Stars) {
-                s.x -= 50.f * deltaTime;
-                if (s.x < 0) s.x = SCR_WIDTH;
-                drawEntity(Entity{ s, glm::vec2(2,2), glm::vec3(1.f),0 });
-            }
+            flushSprites();
 
             renderText("Welcome to ZapValks!", 600.0f, 200.0f, 6.0f, glm::vec3(0.2f, 0.8f, 0.2f));
-            renderText("Press I for Instructions", 700.0f, 350.0f, 4.0f, glm::vec3(0.7f, 0.7f, 0.7f));
-            renderText("Press ENTER to begin", 700.0f, 430.0f, 4.0f, glm::vec3(1.0f, 1.0f, 0.0f));
+            if (netJoined) {
+                renderText(netClient.connected() ? "Co-op: connected, the host starts the game" : "Co-op: joining...",
+                    600.0f, 430.0f, 4.0f, glm::vec3(1.0f, 0.6f, 0.2f));
+            }
+            else {
+                renderText("Press I for Instructions", 700.0f, 350.0f, 4.0f, glm::vec3(0.7f, 0.7f, 0.7f));
+                renderText("Press ENTER to begin", 700.0f, 430.0f, 4.0f, glm::vec3(1.0f, 1.0f, 0.0f));
+            }
+            if (netHost.isOpen()) {
+                char coopStr[64];
+                if (netHost.connected()) sprintf_s(coopStr, "Co-op: partner connected");
+                else sprintf_s(coopStr, "Co-op: waiting for a partner on port %u", (unsigned)netHost.port());
+                renderText(coopStr, 600.0f, 510.0f, 3.0f, glm::vec3(1.0f, 0.6f, 0.2f));
+            }
 
             renderText("Built By:", 700.0f, 650.0f, 4.0f, glm::vec3(0.2f, 0.8f, 0.2f));
             renderText("Ashmit (102203790)", 700.0f, 730.0f, 4.0f, glm::vec3(0.7f, 0.7f, 0.7f));
@@ -548,15 +1616,10 @@ void main(){
             renderText("Sayiam (102203777)", 700.0f, 850.0f, 4.0f, glm::vec3(0.7f, 0.7f, 0.7f));
         }
 
-        else if (state == INSTRUCTIONS) {
+        else if (view.State == INSTRUCTIONS) {
             glClearColor(0.05f, 0.05f, 0.2f, 1.f);
 
-            // starfield
-            for (auto& s : Stars) {
-                s.x -= 50.f * deltaTime;
-                if (s.x < 0) s.x = SCR_WIDTH;
-                drawEntity(Entity{ s, glm::vec2(2,2), glm::vec3(1.f),0 });
-            }
+            flushSprites();
 
             renderText("INSTRUCTIONS", 750.0f, 200.0f, 6.0f, glm::vec3(0.2f, 0.8f, 0.2f));
             renderText("Use W and S to move Up and Down", 600.0f, 400.0f, 4.0f, glm::vec3(1.0f, 1.0f, 0.0f));
@@ -567,68 +1630,210 @@ void main(){
             renderText("Press BACKSPACE to go to Main Menu", 600.0f, 800.0f, 4.0f, glm::vec3(1.0f, 1.0f, 0.0f));
         }
 
-        else if (state == PLAYING) {
-            // starfield
-            for (auto& s : Stars) {
-                s.x -= 50.f * deltaTime;
-                if (s.x < 0) s.x = SCR_WIDTH;
-                // draw tiny white star
-                drawEntity(Entity{ s, glm::vec2(2,2), glm::vec3(1.f),0 });
-            }
+        else if (view.State == PLAYING) {
 
             // player
-            drawTexturedSprite(Player.Position, Player.Size, playerTexID);
+            glm::vec2 playerPos = glm::mix(view.PrevPlayerPosition, view.Player.Position, alpha);
+            drawTexturedSprite(LAYER_ACTORS, playerPos, view.Player.Size, playerSprite);
+            // co-op partner, and a stripe in each ship's colour under it to tell them apart
+            if (view.Coop) {
+                glm::vec2 partnerPos = glm::mix(view.PrevPartnerPosition, view.Partner.Position, alpha);
+                drawTexturedSprite(LAYER_ACTORS, partnerPos, view.Partner.Size, playerSprite);
+                drawRect(LAYER_HUD, playerPos - glm::vec2(0, 8), glm::vec2(view.Player.Size.x, 4), view.Player.Color);
+                drawRect(LAYER_HUD, partnerPos - glm::vec2(0, 8), glm::vec2(view.Partner.Size.x, 4), view.Partner.Color);
+            }
 
             // bullets
-            for (auto& b : Bullets)
-                drawEntity(Entity{ b.Position, glm::vec2(10,4), b.Color,0 });
+            const EntityStore& bullets = view.Bullets;
+            for (size_t i = 0; i < bullets.size(); ++i) {
+                glm::vec2 pos = glm::mix(bullets.PrevPosition[i], bullets.Position[i], alpha);
+                drawRect(LAYER_BULLETS, pos, bullets.Size[i], BULLET_COLOR);
+            }
             // enemies
-            for (auto& e : Enemies)
-                drawTexturedEntity(e);
+            for (size_t i = 0; i < view.Enemies.size(); ++i)
+                drawTexturedEntity(view.Enemies, i, alpha);
 
             // health bar
-            float w = 200.f * (Player.Health > 0 ? Player.Health : 0.f) / 100.f;
+            float w = 200.f * (view.Player.Health > 0 ? view.Player.Health : 0.f) / 100.f;
+            drawRect(LAYER_HUD, glm::vec2(10,10), glm::vec2(w,20), glm::vec3(0.1f,0.8f,0.1f));
+            flushSprites();
+
             renderText("Healthbar", 20.0f, 1000.0f, 3.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-            drawEntity(Entity{ glm::vec2(10,10), glm::vec2(w,20), glm::vec3(0.1f,0.8f,0.1f),0 });
 
             // text to show score
             char scoreStr[32], healthStr[32];
-            sprintf_s(scoreStr, "Score: %d", score);
-            sprintf_s(healthStr, "Health: %.0f", Player.Health);
+            sprintf_s(scoreStr, "Score: %d", view.Score);
+            sprintf_s(healthStr, "Health: %.0f", view.Player.Health);
             renderText(healthStr, 20.0f, 80.0f, 3.0f, glm::vec3(0.6f, 1.0f, 0.6f));
             renderText(scoreStr, 20.0f, 130.0f, 3.0f, glm::vec3(1.0f, 1.0f, 1.0f));
         }
 
-        else if (state == GAME_OVER) {
+        else if (view.State == GAME_OVER) {
             glClearColor(0.2f, 0.05f, 0.05f, 1.f);
 
-            // starfield
-            for (auto& s : Stars) {
-                s.x -= 50.f * deltaTime;
-                if (s.x < 0) s.x = SCR_WIDTH;
-                // draw tiny white star
-                drawEntity(Entity{ s, glm::vec2(2,2), glm::vec3(1.f),0 });
-            }
+            flushSprites();
 
             renderText("GAME OVER", 720.0f, 200.0f, 8.0f, glm::vec3(1.0f, 0.2f, 0.2f));
 
             char finalScoreStr[64];
-            sprintf_s(finalScoreStr, "Your Score: %d", score);
+            sprintf_s(finalScoreStr, "Your Score: %d", view.Score);
             renderText(finalScoreStr, 780.0f, 400.0f, 4.0f, glm::vec3(1.0f, 1.0f, 1.0f));
 
             char highScoreStr[64];
-            sprintf_s(highScoreStr, "High Score: %d", highScore);
+            sprintf_s(highScoreStr, "High Score: %d", view.HighScore);
             renderText(highScoreStr, 750.0f, 480.0f, 4.0f, glm::vec3(1.0f, 1.0f, 0.6f));
 
             renderText("Press ENTER to play again", 680.0f, 560.0f, 4.0f, glm::vec3(0.8f, 0.8f, 0.2f));
         }
 
-        glfwSwapBuffers(window);
+        drawParticles(jobs);
+        if (showProfiler) drawProfilerOverlay();
+        flushText();
+        {
+            PROFILE_SCOPE("submit");
+            beginGpuTimer("draw");
+            renderQueue.submit();
+            endGpuTimer();
+        }
+
+        // upscale into the window (or the headless target), black bars
+        // where the aspect ratios differ
+        {
+            GLuint outFbo = headless ? offscreen.framebuffer() : 0;
+            int x0, y0, x1, y1;
+            letterbox(outW, outH, x0, y0, x1, y1);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outFbo);
+            glViewport(0, 0, outW, outH);
+            if (x0 > 0 || y0 > 0) {
+                GLfloat clearColor[4];
+                glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+                glClearColor(0.f, 0.f, 0.f, 1.f);
+                glClear(GL_COLOR_BUFFER_BIT);
+                glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+            }
+            sceneTarget.blit(outFbo, sceneW, sceneH, x0, y0, x1, y1);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, outFbo);
+        }
+        streamVBO.endFrame();
+        dynamicRes.endFrame();
+        if (capturing) capture.capture(frameIndex);
+        frameIndex++;
+        gProfiler.endZone();
+
+        statsTimer += deltaTime;
+        if (!headless && statsTimer >= 1.f) {
+            sprintf_s(titleStr, "ZapValks | draw calls: %u | sprites: %u | scale: %d%%", frameStats.drawCalls,
+                frameStats.instances, (int)(dynamicRes.scale() * 100.f + 0.5f));
+            glfwSetWindowTitle(window, titleStr);
+            statsTimer = 0.f;
+        }
+        gProfiler.setCounter("draw calls", frameStats.drawCalls);
+        gProfiler.setCounter("sprites", frameStats.instances);
+        gProfiler.setCounter("text glyphs", frameStats.glyphs);
+        gProfiler.setCounter("particles", (double)particles.size());
+        gProfiler.setCounter("buffer uploads", frameStats.bufferUploads);
+        GLStateCache::Stats stateStats = renderQueue.state().takeStats();
+        gProfiler.setCounter("state changes", stateStats.Issued);
+        gProfiler.setCounter("state calls saved", stateStats.Skipped);
+        gProfiler.setCounter("render scale %", dynamicRes.scale() * 100.0);
+        gProfiler.setCounter("pacing wait ms", paceMs);
+        gProfiler.setCounter("input dropped", (double)inputQueue.dropped());
+        gProfiler.setCounter("gpu frame ms", dynamicRes.gpuMs());
+        StreamBuffer::Stats streamStats = streamVBO.takeStats();
+        gProfiler.setCounter("stream bytes", (double)streamStats.BytesStreamed);
+        gProfiler.setCounter("fence waits", streamStats.FenceWaits);
+        AudioStats audioStats = audio.stats();
+        gProfiler.setCounter("voices busy", audioStats.VoicesBusy);
+        gProfiler.setCounter("voice steals", (double)audioStats.Steals);
+        gProfiler.setCounter("audio callback us", audioStats.CallbackUsPeak);
+        if (netHost.isOpen() || netJoined) {
+            const NetStats& net = netJoined ? netClient.stats() : netHost.stats();
+            gProfiler.setCounter("net snapshot bytes", net.SnapshotBytes);
+            gProfiler.setCounter("net kbit/s", net.KbitPerSec);
+            gProfiler.setCounter("net rtt ms", net.RttMs);
+            gProfiler.setCounter("net corrections", (double)net.Corrections);
+            gProfiler.setCounter("net entities", net.Entities);
+        }
+        frameStats = RenderStats();
+
+        if (!headless) {
+            PROFILE_SCOPE("swapBuffers");
+            glfwSwapBuffers(window);
+            if (pacer.synced()) lastSwapFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        if (keyOnScreenUs >= 0) {
+            double ms = (gProfiler.nowUs() - keyOnScreenUs) / 1000.0;
+            inputLatency.add(ms);
+            gProfiler.setCounter("input latency ms", ms);
+            keyOnScreenUs = -1;
+        }
+        gProfiler.endFrame();
+        frameTimes.add(gProfiler.lastFrameMs());
+        if (telemetryOn) {
+            windowTimes.add(gProfiler.lastFrameMs());
+            windowTimer += deltaTime;
+            if (windowTimer >= TELEMETRY_WINDOW_SECONDS) {
+                telemetry.push(TelemetryType::FRAME_TIMES, view.Tick, (uint32_t)(windowTimes.percentile(0.5) * 1000.0),
+                    (uint32_t)(windowTimes.percentile(0.9) * 1000.0), (uint32_t)(windowTimes.percentile(0.99) * 1000.0),
+                    (uint32_t)(windowTimes.maxFrameMs() * 1000.0));
+                windowTimes.clear();
+                windowTimer = 0.f;
+            }
+        }
+
+#ifndef NDEBUG
+        if (view.State == PLAYING && !allocCheckSkip) {
+            if (++playingFrames > ALLOC_CHECK_WARMUP_FRAMES)
+                assert(heapAllocs.load() == allocsAtFrameStart && "heap allocation in a PLAYING frame");
+        }
+        else playingFrames = 0;
+        allocCheckSkip = false;
+#endif
     }
 
-    ma_sound_uninit(&shootSound);
-    ma_engine_uninit(&engine);
-    glfwTerminate();
+    jobs.wait(simJob);
+    recorder.close(sim.Tick);
+    if (telemetryOn) {
+        pushSimTelemetry();
+        telemetry.push(TelemetryType::SESSION_END, sim.Tick, (uint32_t)frameTimes.frames(), (uint32_t)telemetry.dropped(),
+            (uint32_t)(frameTimes.percentile(0.99) * 1000.0), (uint32_t)(frameTimes.maxFrameMs() * 1000.0));
+        telemetry.close();
+    }
+    frameTimes.print(stdout);
+    printf("input latency (key press to swap), per press: ");
+    inputLatency.print(stdout);
+    if (histogramPath && !frameTimes.writeCsv(histogramPath)) {
+        std::cerr << "Failed to write " << histogramPath << "\n";
+    }
+    if (netHost.isOpen() || netJoined) {
+        const NetStats& net = netJoined ? netClient.stats() : netHost.stats();
+        printf("net: %llu snapshots, %.1f bytes avg, %u peak, %.1f kbit/s, rtt %.1f ms, %llu corrections\n",
+            (unsigned long long)net.Snapshots, net.Snapshots ? (double)net.SnapshotTotalBytes / net.Snapshots : 0.0,
+            net.PeakSnapshotBytes, net.KbitPerSec, net.RttMs, (unsigned long long)net.Corrections);
+        netHost.close();
+        netClient.close();
+    }
+
+    int exitCode = 0;
+    if (capturing) {
+        capture.finish();
+        if (goldenDir) {
+            printf("golden: %d of %d frames match\n", capture.framesChecked() - capture.framesFailed(), capture.framesChecked());
+            if (capture.framesFailed()) exitCode = 1;
+        }
+    }
+
+    if (lastSwapFence) glDeleteSync(lastSwapFence);
+    audio.shutdown();
+    streamVBO.destroy();
+    renderQueue.destroy();
+    dynamicRes.destroy();
+    sceneTarget.destroy();
+    if (headless) {
+        offscreen.destroy();
+        headlessContext.shutdown();
+    }
+    else glfwTerminate();
 
-    return 0;
+    return exitCode;
 }
\ No newline at end of file
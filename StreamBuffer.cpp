@@ -0,0 +1,149 @@
+#include "StreamBuffer.h"
+
+#include <chrono>
+#include <cstring>
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+// every allocation starts on this boundary, enough for any vertex attribute
+static const size_t STREAM_ALIGN = 16;
+
+static bool hasBufferStorage() {
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major > 4 || (major == 4 && minor >= 4)) return true;
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (ext && strcmp(ext, "GL_ARB_buffer_storage") == 0) return true;
+    }
+    return false;
+}
+
+bool StreamBuffer::init(GLenum bufferTarget, size_t bytes, GLADloadproc getProc, bool allowPersistent) {
+    destroy();
+    target = bufferTarget;
+    segmentBytes = (bytes + STREAM_ALIGN - 1) & ~(STREAM_ALIGN - 1);
+    bufferStorage = nullptr;
+    if (allowPersistent && getProc && hasBufferStorage())
+        bufferStorage = (BufferStorageFn)getProc("glBufferStorage");
+    create();
+    return vbo != 0;
+}
+
+void StreamBuffer::create() {
+    size_t total = segmentBytes * SEGMENTS;
+    glGenBuffers(1, &vbo);
+    glBindBuffer(target, vbo);
+    if (bufferStorage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage(target, (GLsizeiptr)total, nullptr, flags);
+        mapped = (uint8_t*)glMapBufferRange(target, 0, (GLsizeiptr)total, flags);
+    }
+    // no storage extension, or the persistent map failed: plain storage
+    if (!mapped) {
+        if (bufferStorage) {
+            glDeleteBuffers(1, &vbo);
+            glGenBuffers(1, &vbo);
+            glBindBuffer(target, vbo);
+            bufferStorage = nullptr;
+        }
+        glBufferData(target, (GLsizeiptr)total, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(target, 0);
+    segment = 0;
+    used = 0;
+}
+
+void StreamBuffer::destroy() {
+    if (!vbo) return;
+    for (GLsync& f : fences) {
+        if (f) glDeleteSync(f);
+        f = nullptr;
+    }
+    if (mapped) {
+        glBindBuffer(target, vbo);
+        glUnmapBuffer(target);
+        glBindBuffer(target, 0);
+        mapped = nullptr;
+    }
+    glDeleteBuffers(1, &vbo);
+    vbo = 0;
+}
+
+void StreamBuffer::waitFence(int s) {
+    if (!fences[s]) return;
+    GLenum r = glClientWaitSync(fences[s], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (r == GL_TIMEOUT_EXPIRED) {
+        auto start = std::chrono::steady_clock::now();
+        while (r == GL_TIMEOUT_EXPIRED)
+            r = glClientWaitSync(fences[s], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);   // 1 ms
+        stats.FenceWaits++;
+        stats.FenceWaitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    glDeleteSync(fences[s]);
+    fences[s] = nullptr;
+}
+
+void StreamBuffer::beginFrame() {
+    if (!vbo) return;
+    // a frame ran out of room: wait for the GPU and start over bigger
+    if (wanted > segmentBytes) {
+        for (int s = 0; s < SEGMENTS; ++s) waitFence(s);
+        size_t grown = segmentBytes * 2;
+        while (grown < wanted) grown *= 2;
+        BufferStorageFn storage = bufferStorage;
+        destroy();
+        segmentBytes = grown;
+        bufferStorage = storage;
+        create();
+    }
+    segment = (segment + 1) % SEGMENTS;
+    used = 0;
+    wanted = 0;
+    waitFence(segment);
+}
+
+void StreamBuffer::endFrame() {
+    if (!vbo || used == 0) return;
+    fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void* StreamBuffer::map(size_t bytes, size_t& offset) {
+    size_t start = (used + STREAM_ALIGN - 1) & ~(STREAM_ALIGN - 1);
+    if (!vbo || start + bytes > segmentBytes) {
+        if (start + bytes > wanted) wanted = start + bytes;
+        return nullptr;
+    }
+    used = start + bytes;
+    if (used > wanted) wanted = used;
+    offset = (size_t)segment * segmentBytes + start;
+    stats.BytesStreamed += bytes;
+
+    glBindBuffer(target, vbo);
+    if (mapped) return mapped + offset;
+    void* p = glMapBufferRange(target, (GLintptr)offset, (GLsizeiptr)bytes,
+        GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    mappedRange = p != nullptr;
+    return p;
+}
+
+void StreamBuffer::unmap() {
+    if (!mappedRange) return;
+    glBindBuffer(target, vbo);
+    glUnmapBuffer(target);
+    mappedRange = false;
+}
+
+StreamBuffer::Stats StreamBuffer::takeStats() {
+    Stats s = stats;
+    stats = Stats();
+    return s;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Ring of SEGMENTS equal regions in one GL buffer for data rewritten every
+// frame. Each frame writes into its own segment, and a fence placed at the
+// end of the frame is waited on before that segment comes round again,
+// so the CPU never overwrites data the GPU may still be reading and the
+// driver never has to orphan or copy.
+//
+// With GL_ARB_buffer_storage (GL 4.4) the buffer is persistently mapped
+// once and map()/unmap() only hand out pointers. On plain GL 3.3 every
+// map() is a glMapBufferRange of just that range with the unsynchronized
+// and invalidate flags; the fences already provide the synchronization.
+//
+// Writers go map() -> fill -> unmap() -> draw with buffer() and the
+// returned byte offset. A frame that needs more than a segment gets
+// nullptr from map(); the buffer is regrown at the next beginFrame().
+class StreamBuffer {
+public:
+    static const int SEGMENTS = 3;
+
+    struct Stats {
+        uint64_t BytesStreamed = 0;   // since the last takeStats()
+        uint32_t FenceWaits = 0;      // beginFrame()s that found the GPU still busy
+        double   FenceWaitMs = 0;
+    };
+
+    StreamBuffer() = default;
+    ~StreamBuffer() { destroy(); }
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    // `getProc` resolves glBufferStorage when the context has it; pass
+    // allowPersistent = false to force the GL 3.3 path
+    bool init(GLenum target, size_t segmentBytes, GLADloadproc getProc, bool allowPersistent = true);
+    void destroy();
+
+    void beginFrame();
+    void endFrame();
+
+    // room for `bytes` in this frame's segment; `offset` receives its
+    // position in buffer(). Leaves the buffer bound to the target.
+    void* map(size_t bytes, size_t& offset);
+    void unmap();
+
+    GLuint buffer() const { return vbo; }
+    bool persistent() const { return mapped != nullptr; }
+    size_t segmentSize() const { return segmentBytes; }
+    Stats takeStats();
+
+private:
+    void create();
+    void waitFence(int segment);
+
+    typedef void (APIENTRY* BufferStorageFn)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+    GLenum target = GL_ARRAY_BUFFER;
+    GLuint vbo = 0;
+    BufferStorageFn bufferStorage = nullptr;
+    uint8_t* mapped = nullptr;            // whole buffer, persistent path only
+    bool   mappedRange = false;           // a 3.3 map() is open
+    size_t segmentBytes = 0;
+    size_t wanted = 0;                    // largest frame seen, for regrowing
+    int    segment = 0;
+    size_t used = 0;                      // bytes taken in the current segment
+    GLsync fences[SEGMENTS] = {};
+    Stats  stats;
+};
@@ -0,0 +1,240 @@
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+uint32_t telemetryChecksum(const TelemetryRecord& r) {
+    const uint8_t* p = (const uint8_t*)&r + sizeof(r.Check);
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < sizeof(TelemetryRecord) - sizeof(r.Check); ++i) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static bool cutFile(const char* path, uint64_t size) {
+#ifdef _WIN32
+    int f = _open(path, _O_WRONLY | _O_BINARY);
+    if (f < 0) return false;
+    bool ok = _chsize_s(f, (__int64)size) == 0 && _commit(f) == 0;
+    _close(f);
+#else
+    int f = ::open(path, O_WRONLY);
+    if (f < 0) return false;
+    bool ok = ftruncate(f, (off_t)size) == 0 && fsync(f) == 0;
+    ::close(f);
+#endif
+    return ok;
+}
+
+bool TelemetryLog::scan(const char* path, TelemetryScan& scan, std::string& error, std::vector<TelemetryRecord>* records) {
+    scan = TelemetryScan();
+    FILE* f = fopen(path, "rb");
+    if (!f) return true;   // no log yet
+
+    TelemetryHeader h;
+    size_t got = fread(&h, 1, sizeof(h), f);
+    if (got < sizeof(h)) {
+        // a crash while the log was being created
+        scan.TornBytes = got;
+        scan.ValidBytes = 0;
+        fclose(f);
+        return true;
+    }
+    if (memcmp(h.Magic, TELEMETRY_MAGIC, 4) != 0 || h.Version != TELEMETRY_VERSION || h.RecordSize != sizeof(TelemetryRecord)) {
+        fclose(f);
+        error = std::string(path) + " is not a telemetry log this build can read";
+        return false;
+    }
+
+    // A bad record followed by good ones was damaged in place and is
+    // skipped; bad or partial records at the very end are a torn tail.
+    uint64_t offset = sizeof(h), validEnd = sizeof(h), skippedSinceValid = 0;
+    TelemetryRecord r;
+    while ((got = fread(&r, 1, sizeof(r), f)) > 0) {
+        offset += got;
+        if (got < sizeof(r) || r.Check != telemetryChecksum(r)) {
+            skippedSinceValid++;
+            continue;
+        }
+        scan.Corrupt += skippedSinceValid;
+        skippedSinceValid = 0;
+        validEnd = offset;
+        scan.Records++;
+        if (records) records->push_back(r);
+        if (r.Type == TelemetryType::SESSION_START) scan.Sessions++;
+        else if (r.Type == TelemetryType::ROUND_END && r.V[0] > 0) {
+            ScoreEntry e{ r.V[0], telemetryU64(r.V[1], r.V[2]) };
+            auto at = std::upper_bound(scan.HighScores.begin(), scan.HighScores.end(), e,
+                [](const ScoreEntry& a, const ScoreEntry& b) { return a.Score > b.Score; });
+            if ((size_t)(at - scan.HighScores.begin()) < HIGH_SCORE_SLOTS) {
+                scan.HighScores.insert(at, e);
+                if (scan.HighScores.size() > HIGH_SCORE_SLOTS) scan.HighScores.pop_back();
+            }
+        }
+    }
+    fclose(f);
+    scan.ValidBytes = validEnd;
+    scan.TornBytes = offset - validEnd;
+    return true;
+}
+
+bool TelemetryLog::recover(const char* path, TelemetryScan& scan, std::string& error) {
+    if (!TelemetryLog::scan(path, scan, error)) return false;
+    if (scan.TornBytes && !cutFile(path, scan.ValidBytes)) {
+        error = std::string("Failed to truncate the torn end of ") + path;
+        return false;
+    }
+    return true;
+}
+
+static bool writeAll(int fd, const void* data, size_t bytes) {
+    const char* p = (const char*)data;
+    while (bytes) {
+#ifdef _WIN32
+        int n = _write(fd, p, (unsigned int)bytes);
+#else
+        ssize_t n = ::write(fd, p, bytes);
+#endif
+        if (n <= 0) return false;
+        p += n;
+        bytes -= (size_t)n;
+    }
+    return true;
+}
+
+static void syncFile(int fd) {
+#ifdef _WIN32
+    _commit(fd);
+#else
+    fsync(fd);
+#endif
+}
+
+bool TelemetryLog::open(const char* path) {
+    close();
+#ifdef _WIN32
+    fd = _open(path, _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+    bool empty = fd >= 0 && _lseeki64(fd, 0, SEEK_END) == 0;
+#else
+    fd = ::open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    bool empty = fd >= 0 && lseek(fd, 0, SEEK_END) == 0;
+#endif
+    if (fd < 0) {
+        std::cerr << "Failed to open " << path << "\n";
+        return false;
+    }
+    if (empty) {
+        TelemetryHeader h;
+        memcpy(h.Magic, TELEMETRY_MAGIC, 4);
+        h.Version = TELEMETRY_VERSION;
+        h.RecordSize = sizeof(TelemetryRecord);
+        writeAll(fd, &h, sizeof(h));
+    }
+    head.store(0);
+    tail.store(0);
+    lost.store(0);
+    stopping = false;
+    writer = std::thread(&TelemetryLog::run, this);
+    return true;
+}
+
+void TelemetryLog::close() {
+    if (!isOpen()) return;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+    fd = -1;
+}
+
+void TelemetryLog::push(TelemetryType type, uint64_t tick, uint32_t v0, uint32_t v1, uint32_t v2, uint32_t v3) {
+    if (!isOpen()) return;
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == QUEUE_SIZE) {
+        lost.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    // the writer fills in the checksum, off the game thread
+    TelemetryRecord& r = ring[h & (QUEUE_SIZE - 1)];
+    r.Type = type;
+    r.Reserved = 0;
+    r.Tick = tick;
+    r.V[0] = v0;
+    r.V[1] = v1;
+    r.V[2] = v2;
+    r.V[3] = v3;
+    head.store(h + 1, std::memory_order_release);
+}
+
+// moves everything queued into `batch`; true if any of it should reach
+// the disk right away
+bool TelemetryLog::drain(std::vector<TelemetryRecord>& batch) {
+    bool urgent = false;
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    uint32_t h = head.load(std::memory_order_acquire);
+    for (; t != h; ++t) {
+        TelemetryRecord r = ring[t & (QUEUE_SIZE - 1)];
+        r.Check = telemetryChecksum(r);
+        urgent |= r.Type == TelemetryType::ROUND_END || r.Type == TelemetryType::SESSION_END;
+        batch.push_back(r);
+    }
+    tail.store(t, std::memory_order_release);
+    return urgent;
+}
+
+void TelemetryLog::run() {
+    std::vector<TelemetryRecord> batch;
+    batch.reserve(QUEUE_SIZE);
+    auto lastSync = std::chrono::steady_clock::now();
+    bool unsynced = false, failed = false;
+    for (;;) {
+        bool stop;
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait_for(lock, std::chrono::milliseconds(WRITE_INTERVAL_MS), [this] { return stopping; });
+            stop = stopping;
+        }
+        // the game has stopped pushing once `stopping` is set, so this
+        // last drain takes everything
+        bool urgent = drain(batch);
+        if (!batch.empty() && !failed) {
+            if (writeAll(fd, batch.data(), batch.size() * sizeof(TelemetryRecord))) unsynced = true;
+            else {
+                // a full disk should not take the game down; stop logging
+                std::cerr << "telemetry: write failed, the rest of this session is not logged\n";
+                failed = true;
+            }
+        }
+        batch.clear();
+
+        auto now = std::chrono::steady_clock::now();
+        if (unsynced && (urgent || stop || now - lastSync >= std::chrono::milliseconds(SYNC_INTERVAL_MS))) {
+            syncFile(fd);
+            unsynced = false;
+            lastSync = now;
+        }
+        if (stop) break;
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class TelemetryType : uint16_t {
+    SESSION_START = 1,   // V: seed lo, seed hi, unix time lo, unix time hi
+    ROUND_START,         // V: none
+    WAVE,                // V: waves fired this round, counting this one
+    COMBAT,              // V: shots, hits, misses since the last COMBAT record
+    ROUND_END,           // V: score, unix time lo, unix time hi, ticks the round lasted
+    FRAME_TIMES,         // V: p50, p90, p99, max frame time in us, over the last window
+    SESSION_END,         // V: frames, records dropped, p99, max frame time in us over the session
+};
+
+// One log entry. Every record is the same size and carries a checksum of
+// the rest of itself, so a reader can tell where a crash cut the file.
+struct TelemetryRecord {
+    uint32_t      Check;   // FNV-1a of the 28 bytes that follow
+    TelemetryType Type;
+    uint16_t      Reserved;
+    uint64_t      Tick;    // simulation tick it happened on
+    uint32_t      V[4];
+};
+static_assert(sizeof(TelemetryRecord) == 32, "telemetry records are written as-is");
+
+const char TELEMETRY_MAGIC[4] = { 'Z', 'V', 'T', 'L' };
+const uint16_t TELEMETRY_VERSION = 1;
+
+// Log file layout, little-endian like the rest of our formats:
+//   "ZVTL"  u16 version  u16 record size
+//   then TelemetryRecords back to back, appended by every session that
+//   ever ran, each session opening with SESSION_START
+struct TelemetryHeader {
+    char     Magic[4];
+    uint16_t Version;
+    uint16_t RecordSize;
+};
+
+uint32_t telemetryChecksum(const TelemetryRecord& r);
+inline uint64_t telemetryU64(uint32_t lo, uint32_t hi) { return (uint64_t)hi << 32 | lo; }
+
+struct ScoreEntry {
+    uint32_t Score;
+    uint64_t UnixTime;
+};
+
+// What a scan of an existing log found.
+struct TelemetryScan {
+    uint64_t Records = 0;     // intact ones
+    uint64_t Sessions = 0;
+    uint64_t Corrupt = 0;     // damaged records between intact ones, skipped
+    uint64_t ValidBytes = 0;  // where the last intact record ends
+    uint64_t TornBytes = 0;   // past that: what a crash left half-written
+    std::vector<ScoreEntry> HighScores;   // best first, at most HIGH_SCORE_SLOTS
+};
+
+// Reads and writes the game's append-only session log (telemetry.zvtl).
+//
+// push() is the only thing the game thread does: it copies a record into a
+// fixed lock-free ring and returns, dropping the record (and counting it)
+// if the ring is full, so it can never stall a frame. A background thread
+// drains the ring every WRITE_INTERVAL_MS into one write() per batch, and
+// fsyncs after a round ends or the session closes, and otherwise at most
+// once per SYNC_INTERVAL_MS.
+class TelemetryLog {
+public:
+    static const uint32_t QUEUE_SIZE = 4096;   // power of two
+    static const int WRITE_INTERVAL_MS = 100;
+    static const int SYNC_INTERVAL_MS = 2000;
+    static const size_t HIGH_SCORE_SLOTS = 10;
+
+    TelemetryLog() = default;
+    ~TelemetryLog() { close(); }
+    TelemetryLog(const TelemetryLog&) = delete;
+    TelemetryLog& operator=(const TelemetryLog&) = delete;
+
+    // Reads the log at `path` without changing it, optionally keeping every
+    // intact record. A missing file is an empty scan; a file with a bad
+    // header is an error.
+    static bool scan(const char* path, TelemetryScan& scan, std::string& error,
+        std::vector<TelemetryRecord>* records = nullptr);
+    // scan(), then truncates a torn tail left by a crash so appending
+    // resumes at a record boundary
+    static bool recover(const char* path, TelemetryScan& scan, std::string& error);
+
+    // append to `path` (created if missing) from a writer thread; call recover() first
+    bool open(const char* path);
+    // writes everything still queued, fsyncs and joins the writer
+    void close();
+    bool isOpen() const { return writer.joinable(); }
+
+    // game thread only; a no-op when closed
+    void push(TelemetryType type, uint64_t tick, uint32_t v0 = 0, uint32_t v1 = 0, uint32_t v2 = 0, uint32_t v3 = 0);
+
+    // records lost before they reached push(), counted with its own drops
+    void addDropped(uint64_t n) { lost.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t dropped() const { return lost.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    bool drain(std::vector<TelemetryRecord>& batch);
+
+    int fd = -1;
+    std::thread writer;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    TelemetryRecord ring[QUEUE_SIZE];
+    std::atomic<uint32_t> head{ 0 };   // written by the game thread
+    std::atomic<uint32_t> tail{ 0 };   // written by the writer
+    std::atomic<uint64_t> lost{ 0 };
+};
@@ -0,0 +1,60 @@
+#include "TextMesh.h"
+
+#include "stb_easy_font.h"
+
+#include <algorithm>
+
+GlyphAtlas::GlyphAtlas() : bitmap((size_t)WIDTH * HEIGHT, 0) {
+    // stb_easy_font draws each glyph as axis-aligned quads on whole pixels;
+    // fill them into the glyph's cell and keep their bounds
+    static char buffer[64 * 64];
+    for (int i = 0; i < GLYPH_COUNT; ++i) {
+        char str[2] = { (char)(FIRST_GLYPH + i), 0 };
+        int cellX = (i % COLUMNS) * GLYPH_CELL, cellY = (i / COLUMNS) * GLYPH_CELL;
+        Glyph& g = glyphs[i];
+        g.Advance = (float)stb_easy_font_width(str);
+
+        int quads = stb_easy_font_print(0, 0, str, nullptr, buffer, sizeof(buffer));
+        int x0 = GLYPH_CELL, y0 = GLYPH_CELL, x1 = 0, y1 = 0;
+        for (int q = 0; q < quads; ++q) {
+            const float* v = (const float*)(buffer + q * 64);   // 4 vertices, 16 bytes each
+            int qx0 = std::max(0, (int)std::min(v[0], v[8]));
+            int qy0 = std::max(0, (int)std::min(v[1], v[9]));
+            int qx1 = std::min(GLYPH_CELL - 1, (int)std::max(v[0], v[8]));
+            int qy1 = std::min(GLYPH_CELL - 1, (int)std::max(v[1], v[9]));
+            if (qx1 <= qx0 || qy1 <= qy0) continue;
+            for (int y = qy0; y < qy1; ++y)
+                std::fill_n(&bitmap[(size_t)(cellY + y) * WIDTH + cellX + qx0], qx1 - qx0, (uint8_t)255);
+            x0 = std::min(x0, qx0); y0 = std::min(y0, qy0);
+            x1 = std::max(x1, qx1); y1 = std::max(y1, qy1);
+        }
+        if (x1 <= x0) continue;   // space
+
+        g.X = (float)x0; g.Y = (float)y0;
+        g.W = (float)(x1 - x0); g.H = (float)(y1 - y0);
+        g.U = (float)(cellX + x0) / WIDTH;
+        g.V = (float)(cellY + y1) / HEIGHT;
+        g.UW = g.W / WIDTH;
+        g.VH = -g.H / HEIGHT;
+    }
+}
+
+size_t GlyphAtlas::layout(const char* text, float scale, GlyphQuad* out, size_t maxQuads) const {
+    float x = 0, y = 0;
+    size_t n = 0;
+    for (const char* c = text; *c && n < maxQuads; ++c) {
+        if (*c == '\n') {
+            x = 0;
+            y += LINE_HEIGHT;
+            continue;
+        }
+        unsigned int i = (unsigned char)*c - FIRST_GLYPH;
+        if (i >= (unsigned int)GLYPH_COUNT) continue;   // stb_easy_font has no glyph for it either
+        const Glyph& g = glyphs[i];
+        if (g.W > 0)
+            out[n++] = GlyphQuad{ (x + g.X) * scale, (y + g.Y) * scale, g.W * scale, g.H * scale,
+                g.U, g.V, g.UW, g.VH };
+        x += g.Advance;
+    }
+    return n;
+}
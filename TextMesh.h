@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One character of laid-out text: where its quad goes and which atlas
+// rect it shows.
+struct GlyphQuad {
+    float X, Y, W, H;      // scaled, y-down, relative to the string's top-left corner
+    float U, V, UW, VH;    // atlas uv of the quad's bottom-left corner and its extent
+};
+
+// stb_easy_font rasterized once into an 8-bit coverage atlas, one cell
+// per printable ASCII character, so a string is one quad per character
+// instead of one per pixel stroke. Layout keeps stb_easy_font's metrics
+// exactly (its per-character advances, no kerning, 12 px lines), so text
+// lands where the stroke meshes used to put it. Rows of pixels() run top
+// to bottom, which is why VH comes out negative.
+class GlyphAtlas {
+public:
+    static const int FIRST_GLYPH = 32;
+    static const int GLYPH_COUNT = 95;
+    static const int GLYPH_CELL = 16;    // px, including a gutter against bleeding
+    static const int COLUMNS = 16;
+    static const int WIDTH = COLUMNS * GLYPH_CELL;
+    static const int HEIGHT = (GLYPH_COUNT + COLUMNS - 1) / COLUMNS * GLYPH_CELL;
+    static const int LINE_HEIGHT = 12;
+
+    GlyphAtlas();
+
+    const uint8_t* pixels() const { return bitmap.data(); }
+
+    // lays out `text` at `scale` into `out` (room for maxQuads) and returns
+    // the number of quads; spaces advance but produce none
+    size_t layout(const char* text, float scale, GlyphQuad* out, size_t maxQuads) const;
+
+private:
+    struct Glyph {
+        float X = 0, Y = 0, W = 0, H = 0;   // unscaled bounds within the cell
+        float U = 0, V = 0, UW = 0, VH = 0;
+        float Advance = 0;
+    };
+    Glyph glyphs[GLYPH_COUNT];
+    std::vector<uint8_t> bitmap;
+};
@@ -0,0 +1,326 @@
+#include "Waves.h"
+
+#include "Simulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// room between formation members, in enemy sizes
+static const float FORMATION_GAP = 1.2f;
+
+static float uniform01(Rng& rng) {
+    return rng.next() * (1.f / 4294967296.f);
+}
+
+static bool parseFormation(const char* s, Formation& out) {
+    static const char* names[] = { "random", "column", "wedge", "block" };
+    for (int i = 0; i < 4; ++i)
+        if (strcmp(s, names[i]) == 0) {
+            out = (Formation)i;
+            return true;
+        }
+    return false;
+}
+
+// one "key=value" of a wave line; `why` says what is wrong with a value
+// that parsed but is out of range
+static bool parseWaveKey(const char* key, const char* value, WaveDef& w, const char*& why) {
+    char* end = nullptr;
+    if (strcmp(key, "delay") == 0) w.Delay = strtof(value, &end);
+    else if (strcmp(key, "count") == 0) {
+        unsigned long n = strtoul(value, &end, 10);
+        if (end != value && (n > MAX_WAVE_COUNT || *value == '-')) {
+            why = "count is out of range";
+            return false;
+        }
+        w.Count = (uint32_t)n;
+    }
+    else if (strcmp(key, "formation") == 0) return parseFormation(value, w.Shape);
+    else if (strcmp(key, "interval") == 0) w.Interval = strtof(value, &end);
+    else if (strcmp(key, "jitter") == 0) w.SpeedJitter = strtof(value, &end);
+    else if (strcmp(key, "size") == 0) {
+        // formations place enemies in [0, WORLD_HEIGHT - size]
+        w.Size = strtof(value, &end);
+        if (end != value && !(w.Size >= 1.f && w.Size < WORLD_HEIGHT)) {
+            why = "size must be at least 1 and less than the world height";
+            return false;
+        }
+    }
+    else if (strcmp(key, "speed") == 0) {
+        // "200" or "150..250"; split first, strtof would take "150." as a number
+        const char* range = strstr(value, "..");
+        w.SpeedStart = w.SpeedEnd = strtof(value, &end);
+        if (range && end == range + 1) end--;
+        if (end == value) return false;
+        if (range && end == range) {
+            w.SpeedEnd = strtof(range + 2, &end);
+            if (end == range + 2) return false;
+        }
+    }
+    else if (strcmp(key, "textures") == 0) {
+        w.TextureMix.clear();
+        const char* p = value;
+        for (;;) {
+            w.TextureMix.push_back(strtof(p, &end));
+            if (end == p || w.TextureMix.back() < 0) return false;
+            if (*end != ',') break;
+            p = end + 1;
+        }
+    }
+    else return false;
+    return end && *end == 0;
+}
+
+bool WaveSet::load(const char* path, std::string& error) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        error = std::string("Failed to open ") + path;
+        return false;
+    }
+    *this = WaveSet();
+    char line[512];
+    int lineNo = 0;
+    bool ok = true;
+    const char* why = "cannot parse";
+    while (ok && fgets(line, sizeof(line), f)) {
+        lineNo++;
+        if (char* hash = strchr(line, '#')) *hash = 0;
+        char* tok = strtok(line, " \t\r\n");
+        if (!tok) continue;
+
+        if (strcmp(tok, "wave") == 0) {
+            WaveDef w;
+            while (ok && (tok = strtok(nullptr, " \t\r\n"))) {
+                char* eq = strchr(tok, '=');
+                if (eq) *eq = 0;
+                ok = eq && parseWaveKey(tok, eq + 1, w, why) && w.Delay >= 0 && w.Interval >= 0;
+            }
+            Waves.push_back(w);
+        }
+        else if (strcmp(tok, "loop") == 0) {
+            LoopFrom = 0;
+            while (ok && (tok = strtok(nullptr, " \t\r\n"))) {
+                if (sscanf(tok, "from=%d", &LoopFrom) == 1) continue;
+                if (sscanf(tok, "count=%f", &CountGrowth) == 1) continue;
+                if (sscanf(tok, "speed=%f", &SpeedGrowth) == 1) continue;
+                ok = false;
+            }
+            if (ok && LoopFrom < -1) {
+                why = "loop from a wave that does not exist";
+                ok = false;
+            }
+        }
+        else if (strcmp(tok, "cap") == 0) {
+            tok = strtok(nullptr, " \t\r\n");
+            ok = tok && *tok != '-' && sscanf(tok, "%u", &MaxCount) == 1;
+            if (ok && MaxCount > MAX_WAVE_COUNT) {
+                why = "cap is out of range";
+                ok = false;
+            }
+        }
+        else if (strcmp(tok, "enemies") == 0) {
+            tok = strtok(nullptr, " \t\r\n");
+            ok = tok && *tok != '-' && sscanf(tok, "%zu", &MaxEnemies) == 1;
+            if (ok && MaxEnemies > MAX_WAVE_ENEMIES) {
+                why = "enemies is out of range";
+                ok = false;
+            }
+        }
+        else ok = false;
+    }
+    fclose(f);
+
+    if (!ok) error = std::string(path) + ":" + std::to_string(lineNo) + ": " + why;
+    else if (Waves.empty()) error = std::string(path) + ": no waves";
+    else if (LoopFrom >= (int)Waves.size()) error = std::string(path) + ": loop from a wave that does not exist";
+    else return true;
+    return false;
+}
+
+WaveSet WaveSet::horde() {
+    // half-second waves, spread over 0.4 s each, growing to 2000 (4000
+    // enemies a second); slow enough to take 12-20 s to cross the screen
+    WaveSet s;
+    WaveDef w;
+    w.Delay = 0.5f;
+    w.Count = 200;
+    w.Interval = 0.0002f;
+    w.SpeedStart = 100.f;
+    w.SpeedEnd = 160.f;
+    w.Size = 48.f;
+    s.Waves.push_back(w);
+    s.LoopFrom = 0;
+    s.CountGrowth = 1.12f;
+    s.MaxCount = 2000;
+    s.MaxEnemies = 65536;
+    return s;
+}
+
+uint32_t WaveSet::largestWave() const {
+    uint32_t most = 0;
+    for (size_t i = 0; i < Waves.size(); ++i) {
+        bool grows = LoopFrom >= 0 && (int)i >= LoopFrom && CountGrowth > 1.f;
+        most = std::max(most, grows ? MaxCount : std::min(Waves[i].Count, MaxCount));
+    }
+    return most;
+}
+
+void WaveScheduler::init(const WaveSet* waveSet) {
+    set = waveSet;
+    if (set) {
+        // every run fire() allows still pending at once
+        size_t n = (size_t)set->largestWave() * MAX_ACTIVE_WAVES;
+        time.reserve(n);
+        position.reserve(n);
+        velocity.reserve(n);
+        size.reserve(n);
+        texID.reserve(n);
+    }
+    reset();
+}
+
+void WaveScheduler::reset() {
+    clock = 0;
+    nextWave = 0;
+    pass = 0;
+    fired = 0;
+    runCount = 0;
+    finished = !set || set->Waves.empty();
+    nextWaveAt = finished ? 0 : set->Waves[0].Delay;
+    time.clear();
+    position.clear();
+    velocity.clear();
+    size.clear();
+    texID.clear();
+}
+
+void WaveScheduler::update(float dt, EntityStore& enemies, Rng& rng, unsigned int textures) {
+    if (!set) return;
+    clock += dt;
+
+    // a few waves per tick at most, so a file of zero delays cannot spin
+    for (int n = 0; n < MAX_ACTIVE_WAVES && !finished && clock >= nextWaveAt; ++n) {
+        fire(set->Waves[nextWave], pass, rng, textures);
+        fired++;
+        if (++nextWave == set->Waves.size()) {
+            if (set->LoopFrom < 0) {
+                finished = true;
+                break;
+            }
+            nextWave = (size_t)set->LoopFrom;
+            pass++;
+        }
+        nextWaveAt += set->Waves[nextWave].Delay;
+    }
+
+    for (int r = 0; r < runCount; ++r) {
+        Run& run = runs[r];
+        size_t due = run.Next;
+        while (due < run.End && time[due] <= clock) due++;
+        if (due == run.Next) continue;
+        enemies.createMany(&position[run.Next], &velocity[run.Next], &size[run.Next], &texID[run.Next], due - run.Next);
+        run.Next = due;
+    }
+}
+
+// drop the spawned part of the schedule, sliding what is left to the front
+void WaveScheduler::compact() {
+    int kept = 0;
+    size_t dst = 0;
+    for (int r = 0; r < runCount; ++r) {
+        Run run = runs[r];
+        size_t n = run.End - run.Next;
+        if (!n) continue;
+        if (run.Next != dst) {
+            std::copy(time.begin() + run.Next, time.begin() + run.End, time.begin() + dst);
+            std::copy(position.begin() + run.Next, position.begin() + run.End, position.begin() + dst);
+            std::copy(velocity.begin() + run.Next, velocity.begin() + run.End, velocity.begin() + dst);
+            std::copy(size.begin() + run.Next, size.begin() + run.End, size.begin() + dst);
+            std::copy(texID.begin() + run.Next, texID.begin() + run.End, texID.begin() + dst);
+        }
+        runs[kept++] = Run{ dst, dst + n };
+        dst += n;
+    }
+    runCount = kept;
+    time.resize(dst);
+    position.resize(dst);
+    velocity.resize(dst);
+    size.resize(dst);
+    texID.resize(dst);
+}
+
+void WaveScheduler::fire(const WaveDef& def, uint32_t wavePass, Rng& rng, unsigned int textures) {
+    compact();
+    if (runCount == MAX_ACTIVE_WAVES) return;   // too many waves still trickling in; skip this one
+
+    uint32_t count = (uint32_t)std::min<double>(set->MaxCount, std::floor(def.Count * std::pow((double)set->CountGrowth, wavePass)));
+    // resizing past what init() reserved would allocate mid-tick
+    if (time.size() + count > time.capacity()) return;
+    float speedScale = std::pow(set->SpeedGrowth, (float)wavePass);
+    float s = def.Size > 0 ? def.Size : ENEMY_SIZE;
+    float gap = s * FORMATION_GAP;
+    float maxY = WORLD_HEIGHT - s;
+
+    uint32_t perColumn = std::max(1u, (uint32_t)(WORLD_HEIGHT / gap));
+    uint32_t columnRows = std::min(count, perColumn);
+    uint32_t blockRows = std::min(perColumn, (uint32_t)std::ceil(std::sqrt((double)count)));
+    float centreY = def.Shape == Formation::WEDGE || def.Shape == Formation::BLOCK ?
+        (float)rng.below((uint32_t)maxY + 1) : 0.f;
+
+    float mixTotal = 0;
+    size_t mixCount = std::min(def.TextureMix.size(), (size_t)textures);
+    for (size_t t = 0; t < mixCount; ++t) mixTotal += def.TextureMix[t];
+
+    size_t first = time.size();
+    size_t n = first + count;
+    time.resize(n);
+    position.resize(n);
+    velocity.resize(n);
+    size.resize(n);
+    texID.resize(n);
+    for (uint32_t k = 0; k < count; ++k) {
+        glm::vec2 p(WORLD_WIDTH, 0.f);
+        switch (def.Shape) {
+        case Formation::RANDOM:
+            p.y = (float)rng.below((uint32_t)maxY);
+            break;
+        case Formation::COLUMN:
+            p.x += (k / perColumn) * gap;
+            p.y = ((k % perColumn) + 0.5f) * (WORLD_HEIGHT / columnRows) - s * 0.5f;
+            break;
+        case Formation::WEDGE: {
+            uint32_t arm = (k + 1) / 2;
+            p.x += arm * gap * 0.7f;
+            p.y = centreY + ((k & 1) ? 1.f : -1.f) * arm * gap * 0.7f;
+            break;
+        }
+        case Formation::BLOCK:
+            p.x += (k / blockRows) * gap;
+            p.y = centreY + ((k % blockRows) - (blockRows - 1) * 0.5f) * gap;
+            break;
+        }
+        p.y = std::min(std::max(p.y, 0.f), maxY);
+
+        float t = count > 1 ? (float)k / (count - 1) : 0.f;
+        float speed = def.SpeedStart + (def.SpeedEnd - def.SpeedStart) * t;
+        if (def.SpeedJitter > 0) speed += def.SpeedJitter * (2.f * uniform01(rng) - 1.f);
+
+        unsigned int tex = 0;
+        if (mixTotal > 0) {
+            float r = uniform01(rng) * mixTotal;
+            while (tex + 1 < mixCount && r >= def.TextureMix[tex]) r -= def.TextureMix[tex++];
+        }
+        else if (textures) tex = rng.below(textures);
+
+        size_t i = first + k;
+        time[i] = clock + k * (double)def.Interval;
+        position[i] = p;
+        velocity[i] = glm::vec2(-speed * speedScale, 0.f);   // negative moves left
+        size[i] = glm::vec2(s, s);
+        texID[i] = tex;
+    }
+    runs[runCount++] = Run{ first, n };
+}
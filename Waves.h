@@ -0,0 +1,110 @@
+#pragma once
+
+#include "EntityStore.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Rng;
+
+// the most a wave file may ask for: enemies in one wave, and in the pool
+const uint32_t MAX_WAVE_COUNT = 100000;
+const size_t   MAX_WAVE_ENEMIES = 1 << 20;
+
+// how a wave's enemies are arranged as they enter from the right
+enum class Formation : uint8_t {
+    RANDOM,   // one at a time at random heights
+    COLUMN,   // evenly spaced down the screen, further columns behind
+    WEDGE,    // a V pointing at the player around a random height
+    BLOCK,    // a square-ish grid around a random height
+};
+
+struct WaveDef {
+    float     Delay = 2.f;          // seconds after the previous wave fired
+    uint32_t  Count = 10;
+    Formation Shape = Formation::RANDOM;
+    float     Interval = 0.f;       // seconds between spawns, 0 = the whole wave at once
+    float     SpeedStart = 150.f;   // px/s of the first enemy...
+    float     SpeedEnd = 250.f;     // ...and of the last, the ones between interpolated
+    float     SpeedJitter = 0.f;    // +- px/s at random on top
+    float     Size = 0.f;           // 0 = ENEMY_SIZE, else 1 px to under WORLD_HEIGHT
+    std::vector<float> TextureMix;  // relative weight per enemy texture, empty = even
+};
+
+// A list of waves and what comes after the last one: nothing, or another
+// pass from LoopFrom with every count and speed grown once more per pass.
+struct WaveSet {
+    std::vector<WaveDef> Waves;
+    int      LoopFrom = -1;         // -1 = stop after the last wave
+    float    CountGrowth = 1.f;
+    float    SpeedGrowth = 1.f;
+    uint32_t MaxCount = MAX_WAVE_COUNT;   // cap on one wave's count after growth
+    size_t   MaxEnemies = 0;        // enemy pool the set wants, 0 = the default
+
+    // Text file, one directive per line, '#' starts a comment:
+    //   wave delay=2 count=12 formation=column speed=150..250 textures=1,1,2
+    //   wave delay=4 count=40 formation=random interval=0.1 jitter=10 size=60
+    //   loop from=1 count=1.2 speed=1.05
+    //   cap 5000
+    //   enemies 8192
+    // Omitted wave keys keep the WaveDef defaults. Counts and caps go up to
+    // MAX_WAVE_COUNT, enemies up to MAX_WAVE_ENEMIES. On failure `error`
+    // names the offending line.
+    bool load(const char* path, std::string& error);
+
+    // Ramps from a few hundred to 50k+ enemies on screen in about half a
+    // minute and holds there: the standard load test for the update,
+    // collision and render paths.
+    static WaveSet horde();
+
+    // the most enemies a single wave can lay out
+    uint32_t largestWave() const;
+};
+
+// Plays a WaveSet on its own clock, which only runs while spawning. A wave
+// is laid out in full the moment it fires, into one contiguous run of the
+// schedule buffer in spawn-time order; each tick, whatever is due goes into
+// the enemy store with a single EntityStore::createMany per active wave.
+class WaveScheduler {
+public:
+    static const int MAX_ACTIVE_WAVES = 8;
+
+    // `set` may be null (no waves) and must outlive the scheduler
+    void init(const WaveSet* set);
+    void reset();
+    bool enabled() const { return set != nullptr; }
+
+    // advance `dt` seconds and spawn what is due; enemies that do not fit
+    // in the store are dropped
+    void update(float dt, EntityStore& enemies, Rng& rng, unsigned int textures);
+
+    uint32_t wavesFired() const { return fired; }
+
+private:
+    struct Run {
+        size_t Next, End;   // unspawned part of one wave in the schedule
+    };
+    void fire(const WaveDef& def, uint32_t pass, Rng& rng, unsigned int textures);
+    void compact();
+
+    const WaveSet* set = nullptr;
+    double   clock = 0;
+    double   nextWaveAt = 0;
+    size_t   nextWave = 0;
+    uint32_t pass = 0;
+    uint32_t fired = 0;
+    bool     finished = false;
+
+    // the schedule, structure-of-arrays like the store it feeds
+    std::vector<double>       time;
+    std::vector<glm::vec2>    position;
+    std::vector<glm::vec2>    velocity;
+    std::vector<glm::vec2>    size;
+    std::vector<unsigned int> texID;
+    Run runs[MAX_ACTIVE_WAVES];
+    int runCount = 0;
+};
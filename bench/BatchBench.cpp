@@ -0,0 +1,68 @@
+// Throughput of SimBatch: env-steps per second for a batch of independent
+// games driven by random actions, the way a training loop would drive it.
+//
+//   g++ -O2 -std=c++17 -pthread -I. bench/BatchBench.cpp SimBatch.cpp Simulation.cpp
+//       EntityStore.cpp Waves.cpp CollisionGrid.cpp Profiler.cpp JobSystem.cpp -o batch_bench
+//   ./batch_bench [--envs N] [--threads N] [--ticks N] [--seconds S]
+
+#include "../JobSystem.h"
+#include "../SimBatch.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char** argv) {
+    SimBatchConfig config;
+    config.Envs = 1024;
+    int threads = 0;
+    double seconds = 2.0;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--envs") == 0 && hasValue) config.Envs = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ticks") == 0 && hasValue) config.TicksPerStep = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seconds") == 0 && hasValue) seconds = atof(argv[++i]);
+    }
+    JobSystem jobs(threads);
+    SimBatch batch(config, threads > 0 ? &jobs : nullptr);
+
+    // hold an action for a while like a policy with frame skip would
+    Rng rng(99);
+    std::vector<SimInput> actions(batch.envs());
+    uint64_t episodes = 0;
+    double totalReward = 0;
+    size_t steps = 0;
+    auto t0 = Clock::now();
+    double s = 0;
+    while (s < seconds) {
+        for (SimInput& a : actions) {
+            uint32_t r = rng.next();
+            if ((r & 7) == 0) {
+                a.Up = (r >> 3) & 1;
+                a.Down = !a.Up && ((r >> 4) & 1);
+                a.Fire = ((r >> 5) & 3) != 0;
+            }
+        }
+        batch.step(actions.data());
+        for (size_t i = 0; i < batch.envs(); ++i) {
+            episodes += batch.dones()[i];
+            totalReward += batch.rewards()[i];
+        }
+        steps++;
+        if ((steps & 15) == 0) s = std::chrono::duration<double>(Clock::now() - t0).count();
+    }
+    s = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    double envSteps = (double)batch.totalSteps();
+    printf("%zu envs, %d ticks per step, %d worker threads\n", batch.envs(), config.TicksPerStep, threads);
+    printf("env-steps/s %.0f  (%.0f per thread)  ticks/s %.0f\n", envSteps / s,
+        envSteps / s / (threads + 1), envSteps * config.TicksPerStep / s);
+    printf("episodes finished %llu  mean reward per step %.3f  observation %zu floats\n",
+        (unsigned long long)episodes, totalReward / envSteps, batch.observationSize());
+    return 0;
+}
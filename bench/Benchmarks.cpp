@@ -0,0 +1,184 @@
+// Headless micro-benchmarks for the per-tick hot paths. Links only the game
+// logic (no GL, GLFW or miniaudio):
+//
+//   g++ -O2 -std=c++17 -pthread -I. bench/Benchmarks.cpp Simulation.cpp EntityStore.cpp
+//       Waves.cpp CollisionGrid.cpp TextMesh.cpp Profiler.cpp JobSystem.cpp -o zap_bench
+//   ./zap_bench [--csv] [--filter name] [--max N] [--threads N]
+//
+// Every benchmark runs at entity counts from 10 to 100k and reports the time
+// of one tick, the time per entity and the heap allocations per tick; the
+// horde load test runs last, at whatever count its waves have reached.
+// --threads N runs the simulation phases on a job system with N workers
+// (default 0, single-threaded); compare runs to see how they scale.
+
+#include "../JobSystem.h"
+#include "../Simulation.h"
+#include "../TextMesh.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <vector>
+
+// allocation counting: every operator new in the process goes through here
+static std::atomic<uint64_t> allocCount{ 0 };
+
+void* operator new(size_t n) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    bool csv = false;
+    const char* filter = nullptr;
+    size_t maxCount = 100000;
+    double minSeconds = 0.1;
+    int threads = 0;
+};
+Options opts;
+
+// Times op() until minSeconds have been spent in it. reset() runs untimed
+// before every op() so each tick starts from the same state.
+void run(const char* name, size_t n, const std::function<void()>& reset, const std::function<void()>& op) {
+    double ns = 0;
+    uint64_t allocs = 0, iters = 0;
+    while (iters < 3 || ns < opts.minSeconds * 1e9) {
+        reset();
+        uint64_t a0 = allocCount.load();
+        auto t0 = Clock::now();
+        op();
+        ns += std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        allocs += allocCount.load() - a0;
+        iters++;
+    }
+    double perTick = ns / iters;
+    if (opts.csv)
+        printf("%s,%zu,%.1f,%.3f,%.3f\n", name, n, perTick, perTick / n, (double)allocs / iters);
+    else
+        printf("%-20s %8zu %14.1f %12.3f %12.3f\n", name, n, perTick, perTick / n, (double)allocs / iters);
+}
+
+bool selected(const char* name) {
+    return !opts.filter || strstr(name, opts.filter);
+}
+
+// n bullets spread over the screen, all flying right
+void fillBullets(EntityStore& s, size_t n, Rng& rng) {
+    s.clear();
+    for (size_t i = 0; i < n; ++i)
+        s.create(glm::vec2((float)rng.below((uint32_t)WORLD_WIDTH), (float)rng.below((uint32_t)WORLD_HEIGHT)),
+            glm::vec2(600.f, 0.f), glm::vec2(10, 4));
+}
+
+// n enemies spread over the screen, all flying left
+void fillEnemies(EntityStore& s, size_t n, Rng& rng) {
+    s.clear();
+    for (size_t i = 0; i < n; ++i)
+        s.create(glm::vec2((float)rng.below((uint32_t)WORLD_WIDTH), (float)rng.below((uint32_t)(WORLD_HEIGHT - ENEMY_SIZE))),
+            glm::vec2(-200.f, 0.f), glm::vec2(ENEMY_SIZE), i % 3);
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--csv") == 0) opts.csv = true;
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) opts.filter = argv[++i];
+        else if (strcmp(argv[i], "--max") == 0 && i + 1 < argc) opts.maxCount = (size_t)atol(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) opts.threads = atoi(argv[++i]);
+    }
+    JobSystem jobs(opts.threads);
+
+    if (opts.csv) printf("benchmark,count,ns_per_tick,ns_per_entity,allocs_per_tick\n");
+    else printf("%-20s %8s %14s %12s %12s\n", "benchmark", "count", "ns/tick", "ns/entity", "allocs/tick");
+
+    const size_t counts[] = { 10, 100, 1000, 10000, 100000 };
+    Rng rng(1234);
+    GlyphAtlas glyphs;
+
+    for (size_t n : counts) {
+        if (n > opts.maxCount) break;
+        SimConfig config;
+        config.MaxBullets = config.MaxEnemies = n;
+        Simulation sim(1, config);
+        if (opts.threads > 0) sim.setJobs(&jobs);
+
+        // spawnEnemy: n spawns into an empty store
+        if (selected("spawnEnemy"))
+            run("spawnEnemy", n, [&] { sim.Enemies.clear(); }, [&] {
+                for (size_t i = 0; i < n; ++i) sim.spawnEnemy();
+            });
+
+        // the same n enemies as one wave: laid out, then bulk-inserted
+        WaveSet oneWave;
+        oneWave.Waves.resize(1);
+        oneWave.Waves[0].Delay = 0.f;
+        oneWave.Waves[0].Count = (uint32_t)n;
+        WaveScheduler scheduler;
+        scheduler.init(&oneWave);
+        if (selected("spawnWave"))
+            run("spawnWave", n, [&] { sim.Enemies.clear(); scheduler.reset(); }, [&] {
+                scheduler.update(SIM_DT, sim.Enemies, rng, config.EnemyTextures);
+            });
+
+        // bullet integration plus off-screen removal
+        EntityStore bullets;
+        fillBullets(bullets, n, rng);
+        if (selected("updateBullets"))
+            run("updateBullets", n, [&] { sim.Bullets = bullets; }, [&] { sim.updateBullets(); });
+
+        // enemy integration
+        EntityStore enemies;
+        fillEnemies(enemies, n, rng);
+        if (selected("updateEnemies"))
+            run("updateEnemies", n, [&] { sim.Enemies = enemies; }, [&] { sim.updateEnemies(); });
+
+        // n enemies against n bullets, including the deferred removal
+        if (selected("resolveCollisions"))
+            run("resolveCollisions", n, [&] { sim.Enemies = enemies; sim.Bullets = bullets; },
+                [&] { sim.resolveCollisions(); });
+
+        // whole tick with the given number of enemies and bullets in flight
+        if (selected("step"))
+            run("step", n, [&] { sim.Enemies = enemies; sim.Bullets = bullets; sim.Player.Health = 100.f; },
+                [&] { sim.step(SimInput{ false, false, true }, true); });
+
+        // text layout: n short HUD strings
+        GlyphQuad quads[32];
+        if (selected("layoutText"))
+            run("layoutText", n, [] {}, [&] {
+                char str[32];
+                for (size_t i = 0; i < n; ++i) {
+                    snprintf(str, sizeof(str), "Score: %zu", i);
+                    glyphs.layout(str, 3.f, quads, 32);
+                }
+            });
+    }
+
+    // the --horde wave preset, stepped with fire held until it has ramped
+    // up, then timed one tick at a time at full load
+    if (selected("horde") && opts.maxCount >= 50000) {
+        WaveSet horde = WaveSet::horde();
+        SimConfig config;
+        config.Waves = &horde;
+        config.MaxEnemies = horde.MaxEnemies;
+        Simulation sim(1, config);
+        if (opts.threads > 0) sim.setJobs(&jobs);
+        SimInput in;
+        in.Fire = true;
+        auto tick = [&] {
+            sim.step(in, true);
+            sim.Player.Health = 100.f;
+        };
+        for (int t = 0; t < 30 * (int)SIM_TICK_RATE; ++t) tick();
+        run("horde", sim.Enemies.size(), [] {}, tick);
+    }
+    return 0;
+}
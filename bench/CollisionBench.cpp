@@ -0,0 +1,130 @@
+// Bullet-vs-enemy collision benchmark: the original O(E*B) loop against the
+// CollisionGrid broad phase, on the same random scenes. Every run also checks
+// that both produce the same score and the same survivors.
+//
+//   g++ -O2 -std=c++17 -I. -I<glm> bench/CollisionBench.cpp CollisionGrid.cpp -o collision_bench
+
+#include "../CollisionGrid.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+const float WORLD_W = 1920.f, WORLD_H = 1080.f, ENEMY_SIZE = 100.f;
+
+struct Bullet { glm::vec2 Position; glm::vec2 Velocity; glm::vec3 Color; };
+struct Enemy  { glm::vec2 Position; glm::vec2 Size; float Speed; unsigned int TexID; };
+
+struct Scene {
+    std::vector<Bullet> bullets;
+    std::vector<Enemy> enemies;
+};
+
+Scene makeScene(size_t enemies, size_t bullets, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> x(-20.f, WORLD_W + 10.f), y(0.f, WORLD_H);
+    Scene s;
+    for (size_t i = 0; i < enemies; ++i)
+        s.enemies.push_back({ glm::vec2(x(rng), y(rng) * (WORLD_H - ENEMY_SIZE) / WORLD_H),
+                              glm::vec2(ENEMY_SIZE), -200.f, 0 });
+    for (size_t i = 0; i < bullets; ++i)
+        s.bullets.push_back({ glm::vec2(x(rng), y(rng)), glm::vec2(600.f, 0.f), glm::vec3(1.f) });
+    return s;
+}
+
+// the loop from main() before the broad phase, minus movement
+unsigned bruteForce(Scene& s) {
+    unsigned score = 0;
+    for (auto eIt = s.enemies.begin(); eIt != s.enemies.end(); ) {
+        bool removed = false;
+        for (auto bIt = s.bullets.begin(); bIt != s.bullets.end(); ) {
+            if (bIt->Position.x > eIt->Position.x &&
+                bIt->Position.x < eIt->Position.x + eIt->Size.x &&
+                bIt->Position.y > eIt->Position.y &&
+                bIt->Position.y < eIt->Position.y + eIt->Size.y)
+            {
+                score += 10;
+                bIt = s.bullets.erase(bIt);
+                eIt = s.enemies.erase(eIt);
+                removed = true;
+                break;
+            }
+            else ++bIt;
+        }
+        if (!removed) ++eIt;
+    }
+    return score;
+}
+
+// the loop from main() with the broad phase and deferred removal
+unsigned gridBased(Scene& s, CollisionGrid& grid, std::vector<uint8_t>& dead) {
+    unsigned score = 0;
+    grid.build(s.bullets.empty() ? nullptr : &s.bullets[0].Position, s.bullets.size(), sizeof(Bullet));
+    dead.assign(s.enemies.size(), 0);
+    for (size_t i = 0; i < s.enemies.size(); ++i) {
+        if (grid.claim(s.enemies[i].Position, s.enemies[i].Size) >= 0) {
+            score += 10;
+            dead[i] = 1;
+        }
+    }
+    size_t alive = 0;
+    for (size_t i = 0; i < s.enemies.size(); ++i)
+        if (!dead[i]) s.enemies[alive++] = s.enemies[i];
+    s.enemies.resize(alive);
+    alive = 0;
+    for (size_t i = 0; i < s.bullets.size(); ++i)
+        if (!grid.isClaimed(i)) s.bullets[alive++] = s.bullets[i];
+    s.bullets.resize(alive);
+    return score;
+}
+
+bool sameSurvivors(const Scene& a, const Scene& b) {
+    if (a.enemies.size() != b.enemies.size() || a.bullets.size() != b.bullets.size()) return false;
+    for (size_t i = 0; i < a.enemies.size(); ++i)
+        if (a.enemies[i].Position != b.enemies[i].Position) return false;
+    for (size_t i = 0; i < a.bullets.size(); ++i)
+        if (a.bullets[i].Position != b.bullets[i].Position) return false;
+    return true;
+}
+
+template <class F>
+double timeMs(F&& f) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    // the quadratic reference gets slow fast; skip it above this size
+    size_t bruteLimit = argc > 1 ? (size_t)atol(argv[1]) : 20000;
+    const size_t counts[] = { 100, 1000, 5000, 10000, 20000, 50000 };
+
+    CollisionGrid grid(WORLD_W, WORLD_H, ENEMY_SIZE);
+    std::vector<uint8_t> dead;
+    bool ok = true;
+
+    printf("%10s %10s %14s %14s %10s\n", "enemies", "bullets", "brute ms", "grid ms", "hits");
+    for (size_t n : counts) {
+        Scene base = makeScene(n, n, (unsigned)n);
+
+        Scene g = base;
+        unsigned gridScore = 0;
+        double gridMs = timeMs([&] { gridScore = gridBased(g, grid, dead); });
+
+        if (n <= bruteLimit) {
+            Scene b = base;
+            unsigned bruteScore = 0;
+            double bruteMs = timeMs([&] { bruteScore = bruteForce(b); });
+            bool match = bruteScore == gridScore && sameSurvivors(b, g);
+            ok = ok && match;
+            printf("%10zu %10zu %14.3f %14.3f %10u%s\n", n, n, bruteMs, gridMs, gridScore / 10,
+                   match ? "" : "  MISMATCH");
+        }
+        else {
+            printf("%10zu %10zu %14s %14.3f %10u\n", n, n, "-", gridMs, gridScore / 10);
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+// A co-op session over loopback UDP, host and client in one process on a
+// simulated clock: a steady stream of enemy waves keeps hundreds of them
+// on screen while both ships fly and fire. Reports what a snapshot costs
+// (bytes and kbit/s on the wire, against a 64 kbit/s budget) and checks
+// that every snapshot the client decodes is exactly what the host encoded,
+// and that the partner's predicted ship never needed correcting.
+//
+//   g++ -O2 -std=c++17 -pthread -I. bench/NetBench.cpp Net.cpp Snapshot.cpp Simulation.cpp
+//       EntityStore.cpp Waves.cpp CollisionGrid.cpp Profiler.cpp JobSystem.cpp -o net_bench
+//   ./net_bench [--seconds S] [--rate HZ] [--wave N] [--port P]
+
+#include "../Net.h"
+#include "../Simulation.h"
+#include "../Waves.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+static bool sameEntities(const std::vector<NetEntity>& a, const std::vector<NetEntity>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        const NetEntity& x = a[i];
+        const NetEntity& y = b[i];
+        // generations are each side's own
+        if (x.Id != y.Id || x.X != y.X || x.Y != y.Y || x.VX != y.VX || x.VY != y.VY || x.W != y.W ||
+            x.H != y.H || x.Tex != y.Tex)
+            return false;
+    }
+    return true;
+}
+
+static bool sameState(const WorldState& a, const WorldState& b) {
+    for (int i = 0; i < 2; ++i)
+        if (a.Ships[i].X != b.Ships[i].X || a.Ships[i].Y != b.Ships[i].Y) return false;
+    return a.Tick == b.Tick && a.Phase == b.Phase && a.Score == b.Score && a.Health == b.Health &&
+        sameEntities(a.Enemies, b.Enemies) && sameEntities(a.Bullets, b.Bullets);
+}
+
+int main(int argc, char** argv) {
+    double seconds = 60.0;
+    int rate = NET_DEFAULT_RATE;
+    uint32_t waveCount = 40;
+    uint16_t port = 0;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--seconds") == 0 && hasValue) seconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--rate") == 0 && hasValue) rate = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--wave") == 0 && hasValue) waveCount = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--port") == 0 && hasValue) port = (uint16_t)atoi(argv[++i]);
+    }
+
+    // a wave a second, each taking 12-19 s to cross: about 15 waves on screen
+    WaveSet waves;
+    WaveDef w;
+    w.Delay = 1.f;
+    w.Count = waveCount;
+    w.Interval = 0.02f;
+    w.SpeedStart = 100.f;
+    w.SpeedEnd = 160.f;
+    w.Size = 64.f;
+    waves.Waves.push_back(w);
+    waves.LoopFrom = 0;
+    waves.MaxEnemies = std::max<size_t>(512, waveCount * 24);
+
+    SimConfig config;
+    config.Waves = &waves;
+    config.MaxEnemies = waves.MaxEnemies;
+    config.Coop = true;
+    Simulation sim(7, config);
+
+    NetHost host;
+    if (!host.open(port, rate, config)) return 1;
+    // with port 0 the host picked a free one
+    NetClient client;
+    std::string target = "127.0.0.1:" + std::to_string(host.port());
+    if (!client.open(target.c_str())) return 1;
+
+    // the host's player sweeps up and down; the partner changes its mind
+    // every quarter second
+    Rng rng(3);
+    SimInput hostIn, partnerIn;
+    hostIn.Fire = partnerIn.Fire = true;
+    const int FRAME_TICKS = 2;   // 60 Hz frames
+    const double FRAME_MS = FRAME_TICKS * 1000.0 / SIM_TICK_RATE;
+    int frames = (int)(seconds * SIM_TICK_RATE / FRAME_TICKS);
+
+    uint64_t checked = 0, mismatched = 0, onScreenTotal = 0, samples = 0;
+    uint32_t onScreenPeak = 0;
+    double nowMs = 0, peakKbit = 0, kbitTotal = 0;
+    uint64_t kbitSamples = 0;
+    const WorldState* lastChecked = nullptr;
+    uint32_t lastCheckedTick = 0;
+    auto t0 = Clock::now();
+    for (int f = 0; f < frames; ++f) {
+        for (int t = 0; t < FRAME_TICKS; ++t) {
+            if (sim.Tick % 240 == 0) hostIn.Up = !hostIn.Up, hostIn.Down = !hostIn.Up;
+            if (sim.Tick % 30 == 0) {
+                uint32_t r = rng.below(3);
+                partnerIn.Up = r == 0;
+                partnerIn.Down = r == 1;
+            }
+            SimInput partner[NetHost::MAX_INPUTS_PER_TICK];
+            size_t n = host.takeInputs(partner, NetHost::MAX_INPUTS_PER_TICK);
+            sim.step(hostIn, true, partner, n);
+            sim.Player.Health = 100.f;
+            client.tick(partnerIn);
+        }
+        nowMs += FRAME_MS;
+        host.update(sim, 2, nowMs);
+        client.update(nowMs);
+
+        const WorldState* got = client.lastReceived();
+        if (got && (got != lastChecked || got->Tick != lastCheckedTick)) {
+            lastChecked = got;
+            lastCheckedTick = got->Tick;
+            checked++;
+            // loopback delivers at once, so the newest decoded is the newest sent
+            if (!host.lastSent() || !sameState(*host.lastSent(), *got)) mismatched++;
+            uint32_t enemies = (uint32_t)got->Enemies.size();
+            onScreenPeak = std::max(onScreenPeak, enemies);
+            onScreenTotal += enemies;
+            samples++;
+        }
+        if (f % 60 == 59 && host.stats().KbitPerSec > 0) {
+            peakKbit = std::max(peakKbit, host.stats().KbitPerSec);
+            kbitTotal += host.stats().KbitPerSec;
+            kbitSamples++;
+        }
+    }
+    double wall = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    const NetStats& hs = host.stats();
+    const NetStats& cs = client.stats();
+    printf("%.0f s of co-op at %d snapshots/s, waves of %u, %.2f s wall\n", seconds, rate, waveCount, wall);
+    printf("enemies per snapshot  avg %.0f  peak %u\n", samples ? (double)onScreenTotal / samples : 0.0, onScreenPeak);
+    printf("snapshot bytes        avg %.1f  peak %u  (limit %zu)\n",
+        hs.Snapshots ? (double)hs.SnapshotTotalBytes / hs.Snapshots : 0.0, hs.PeakSnapshotBytes, NET_MAX_PACKET);
+    printf("bandwidth             avg %.1f  peak %.1f kbit/s with UDP/IP headers  (budget 64): %s\n",
+        kbitSamples ? kbitTotal / kbitSamples : 0.0, peakKbit, peakKbit < 64.0 ? "ok" : "OVER");
+    printf("snapshots             sent %llu  decoded %llu  checked %llu  mismatched %llu\n",
+        (unsigned long long)hs.Snapshots, (unsigned long long)cs.Snapshots, (unsigned long long)checked,
+        (unsigned long long)mismatched);
+    printf("partner corrections   %llu (last %.2f px)\n", (unsigned long long)cs.Corrections, cs.LastCorrection);
+    printf("score %u\n", sim.Score);
+    return mismatched || cs.Corrections ? 1 : 0;
+}
@@ -0,0 +1,257 @@
+// Offline asset packer: bakes sprites into one RGBA atlas with its mip
+// chain, and decodes sounds to PCM, into a single archive the game maps
+// at startup (format in AssetPack.h). Built on its own, not part of the game:
+//
+//   g++ -O2 -std=c++17 -I. tools/AssetPacker.cpp -o zap_pack
+//   ./zap_pack assets.zvpk --sprite enemy1=path/Valkyrie_1.png ... --sound shoot=path/shoot.mp3
+//
+// The game looks up sprites "player", "enemy1", "enemy2", ... and the sound
+// "shoot".
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#define MINIAUDIO_IMPLEMENTATION
+#include "SDL3/miniaudio.h"
+
+#include "../AssetPack.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Sprites sit on a grid of MIP_BLOCK pixels with a gutter of edge pixels
+// around them, so the first MIP_LEVELS levels never blend neighbours.
+static const int MIP_LEVELS = 5;
+static const int MIP_BLOCK = 1 << (MIP_LEVELS - 1);
+static const int GUTTER = MIP_BLOCK / 2;
+static const int MAX_ATLAS = 8192;
+
+// what the game's audio device runs at (AudioSystem::init)
+static const uint32_t SOUND_CHANNELS = 2;
+static const uint32_t SOUND_RATE = 48000;
+
+struct SpriteSrc {
+    std::string Name, Path;
+    int W = 0, H = 0;
+    unsigned char* Pixels = nullptr;
+    int X = 0, Y = 0;   // placement of the padded cell
+};
+
+struct SoundSrc {
+    std::string Name, Path;
+    ma_uint64 Frames = 0;
+    void* Pcm = nullptr;
+};
+
+static int roundUp(int v, int to) { return (v + to - 1) / to * to; }
+static int cellW(const SpriteSrc& s) { return roundUp(s.W + 2 * GUTTER, MIP_BLOCK); }
+static int cellH(const SpriteSrc& s) { return roundUp(s.H + 2 * GUTTER, MIP_BLOCK); }
+
+// shelf packing, tallest first; returns the height used, or -1 if a row
+// does not fit in `width`
+static int packShelves(std::vector<SpriteSrc*>& order, int width) {
+    int x = 0, y = 0, shelfH = 0;
+    for (SpriteSrc* s : order) {
+        if (cellW(*s) > width) return -1;
+        if (x + cellW(*s) > width) {
+            y += shelfH;
+            x = shelfH = 0;
+        }
+        s->X = x;
+        s->Y = y;
+        x += cellW(*s);
+        shelfH = std::max(shelfH, cellH(*s));
+    }
+    return y + shelfH;
+}
+
+static int nextPow2(int v) {
+    int p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+// copy a sprite into its cell and smear its edge pixels over the gutter
+static void blit(std::vector<unsigned char>& atlas, int atlasW, const SpriteSrc& s) {
+    int cw = cellW(s), ch = cellH(s);
+    for (int y = 0; y < ch; ++y) {
+        int sy = std::min(std::max(y - GUTTER, 0), s.H - 1);
+        for (int x = 0; x < cw; ++x) {
+            int sx = std::min(std::max(x - GUTTER, 0), s.W - 1);
+            memcpy(&atlas[((size_t)(s.Y + y) * atlasW + s.X + x) * 4], &s.Pixels[((size_t)sy * s.W + sx) * 4], 4);
+        }
+    }
+}
+
+// 2x2 box filter; colour is weighted by alpha so transparent texels do
+// not darken the edges
+static std::vector<unsigned char> downsample(const std::vector<unsigned char>& src, int w, int h) {
+    int dw = std::max(w / 2, 1), dh = std::max(h / 2, 1);
+    std::vector<unsigned char> dst((size_t)dw * dh * 4);
+    for (int y = 0; y < dh; ++y) {
+        for (int x = 0; x < dw; ++x) {
+            float rgb[3] = { 0, 0, 0 }, a = 0;
+            for (int k = 0; k < 4; ++k) {
+                int sx = std::min(x * 2 + (k & 1), w - 1), sy = std::min(y * 2 + (k >> 1), h - 1);
+                const unsigned char* p = &src[((size_t)sy * w + sx) * 4];
+                for (int c = 0; c < 3; ++c) rgb[c] += p[c] * (p[3] / 255.f);
+                a += p[3] / 255.f;
+            }
+            unsigned char* d = &dst[((size_t)y * dw + x) * 4];
+            for (int c = 0; c < 3; ++c) d[c] = a > 0 ? (unsigned char)(rgb[c] / a + 0.5f) : 0;
+            d[3] = (unsigned char)(a / 4.f * 255.f + 0.5f);
+        }
+    }
+    return dst;
+}
+
+static bool splitArg(const char* arg, std::string& name, std::string& path) {
+    const char* eq = strchr(arg, '=');
+    if (!eq || eq == arg || eq - arg >= 32) return false;
+    name.assign(arg, eq);
+    path = eq + 1;
+    return true;
+}
+
+static void pad16(FILE* f) {
+    static const char zeros[16] = {};
+    long pos = ftell(f);
+    fwrite(zeros, 1, (size_t)((16 - pos % 16) % 16), f);
+}
+
+static void usage() {
+    printf("usage: zap_pack out.zvpk [--sprite name=image.png]... [--sound name=audio.mp3]...\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) { usage(); return 1; }
+    const char* outPath = argv[1];
+    std::vector<SpriteSrc> sprites;
+    std::vector<SoundSrc> sounds;
+    for (int i = 2; i < argc; ++i) {
+        std::string name, path;
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--sprite") == 0 && hasValue && splitArg(argv[i + 1], name, path)) {
+            sprites.push_back(SpriteSrc{ name, path });
+            ++i;
+        }
+        else if (strcmp(argv[i], "--sound") == 0 && hasValue && splitArg(argv[i + 1], name, path)) {
+            sounds.push_back(SoundSrc{ name, path });
+            ++i;
+        }
+        else { usage(); return 1; }
+    }
+
+    // decode everything up front
+    stbi_set_flip_vertically_on_load(true);   // the game samples bottom-up
+    for (SpriteSrc& s : sprites) {
+        int chan;
+        s.Pixels = stbi_load(s.Path.c_str(), &s.W, &s.H, &chan, STBI_rgb_alpha);
+        if (!s.Pixels) { printf("cannot load %s\n", s.Path.c_str()); return 1; }
+    }
+    for (SoundSrc& s : sounds) {
+        ma_decoder_config config = ma_decoder_config_init(ma_format_f32, SOUND_CHANNELS, SOUND_RATE);
+        if (ma_decode_file(s.Path.c_str(), &config, &s.Frames, &s.Pcm) != MA_SUCCESS) {
+            printf("cannot decode %s\n", s.Path.c_str());
+            return 1;
+        }
+    }
+
+    // smallest power-of-two square-ish atlas that holds every sprite
+    std::vector<SpriteSrc*> order;
+    for (SpriteSrc& s : sprites) order.push_back(&s);
+    std::sort(order.begin(), order.end(), [](const SpriteSrc* a, const SpriteSrc* b) { return a->H > b->H; });
+    int atlasW = MIP_BLOCK, atlasH = MIP_BLOCK;
+    for (int w = MIP_BLOCK; w <= MAX_ATLAS; w *= 2) {
+        int used = packShelves(order, w);
+        if (used >= 0 && used <= w) {
+            atlasW = w;
+            atlasH = nextPow2(std::max(used, MIP_BLOCK));
+            break;
+        }
+        if (w == MAX_ATLAS) { printf("sprites do not fit in %dx%d\n", MAX_ATLAS, MAX_ATLAS); return 1; }
+    }
+
+    std::vector<std::vector<unsigned char>> levels(1);
+    levels[0].assign((size_t)atlasW * atlasH * 4, 0);
+    for (const SpriteSrc& s : sprites) blit(levels[0], atlasW, s);
+    int mipCount = 1;
+    for (int w = atlasW, h = atlasH; mipCount < MIP_LEVELS && (w > 1 || h > 1); ++mipCount) {
+        levels.push_back(downsample(levels.back(), w, h));
+        w = std::max(w / 2, 1);
+        h = std::max(h / 2, 1);
+    }
+
+    // tables first, with offsets filled in from the blob sizes
+    PackHeader header = {};
+    memcpy(header.Magic, "ZVPK", 4);
+    header.Version = PACK_VERSION;
+    header.AtlasWidth = (uint32_t)atlasW;
+    header.AtlasHeight = (uint32_t)atlasH;
+    header.MipCount = (uint32_t)mipCount;
+    header.SpriteCount = (uint32_t)sprites.size();
+    header.SoundCount = (uint32_t)sounds.size();
+
+    uint64_t offset = sizeof(PackHeader) + mipCount * sizeof(PackMip)
+        + sprites.size() * sizeof(PackSprite) + sounds.size() * sizeof(PackSound);
+    auto place = [&](uint64_t bytes) {
+        offset = (offset + 15) & ~15ull;
+        uint64_t at = offset;
+        offset += bytes;
+        return at;
+    };
+
+    std::vector<PackMip> mipTable;
+    for (int l = 0; l < mipCount; ++l) {
+        uint32_t w = std::max(atlasW >> l, 1), h = std::max(atlasH >> l, 1);
+        mipTable.push_back(PackMip{ w, h, place((uint64_t)w * h * 4) });
+    }
+    std::vector<PackSprite> spriteTable;
+    for (const SpriteSrc& s : sprites) {
+        PackSprite p = {};
+        strncpy(p.Name, s.Name.c_str(), sizeof(p.Name) - 1);
+        p.U0 = (float)(s.X + GUTTER) / atlasW;
+        p.V0 = (float)(s.Y + GUTTER) / atlasH;
+        p.U1 = (float)(s.X + GUTTER + s.W) / atlasW;
+        p.V1 = (float)(s.Y + GUTTER + s.H) / atlasH;
+        p.Width = (uint32_t)s.W;
+        p.Height = (uint32_t)s.H;
+        spriteTable.push_back(p);
+    }
+    std::vector<PackSound> soundTable;
+    for (const SoundSrc& s : sounds) {
+        PackSound p = {};
+        strncpy(p.Name, s.Name.c_str(), sizeof(p.Name) - 1);
+        p.Channels = SOUND_CHANNELS;
+        p.SampleRate = SOUND_RATE;
+        p.Frames = s.Frames;
+        p.Offset = place(s.Frames * SOUND_CHANNELS * sizeof(float));
+        soundTable.push_back(p);
+    }
+
+    FILE* f = fopen(outPath, "wb");
+    if (!f) { printf("cannot write %s\n", outPath); return 1; }
+    fwrite(&header, sizeof(header), 1, f);
+    fwrite(mipTable.data(), sizeof(PackMip), mipTable.size(), f);
+    fwrite(spriteTable.data(), sizeof(PackSprite), spriteTable.size(), f);
+    fwrite(soundTable.data(), sizeof(PackSound), soundTable.size(), f);
+    for (int l = 0; l < mipCount; ++l) {
+        pad16(f);
+        fwrite(levels[l].data(), 1, levels[l].size(), f);
+    }
+    for (const SoundSrc& s : sounds) {
+        pad16(f);
+        fwrite(s.Pcm, sizeof(float) * SOUND_CHANNELS, (size_t)s.Frames, f);
+    }
+    long total = ftell(f);
+    fclose(f);
+
+    printf("%s: %dx%d atlas, %d mips, %zu sprites, %zu sounds, %ld bytes\n",
+        outPath, atlasW, atlasH, mipCount, sprites.size(), sounds.size(), total);
+    for (SpriteSrc& s : sprites) stbi_image_free(s.Pixels);
+    for (SoundSrc& s : sounds) ma_free(s.Pcm, NULL);
+    return 0;
+}
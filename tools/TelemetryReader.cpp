@@ -0,0 +1,212 @@
+// Offline reader for the game's session log (format in Telemetry.h):
+// summarizes sessions, their rounds and waves, frame times and the
+// high-score table. Never modifies the log. Built on its own:
+//
+//   g++ -O2 -std=c++17 -pthread -I. tools/TelemetryReader.cpp Telemetry.cpp -o zap_telemetry
+//   ./zap_telemetry [telemetry.zvtl] [--all | --session N]
+//
+// By default only the last session is shown in detail.
+
+#include "../Telemetry.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+const double TICK_RATE = 120.0;   // SIM_TICK_RATE; the reader does not link the simulation
+
+struct WaveStats {
+    uint32_t Number = 0;   // 0 = before the first wave, or no waves at all
+    uint64_t Shots = 0, Hits = 0, Misses = 0;
+};
+
+struct RoundStats {
+    uint32_t Score = 0;
+    uint64_t Ticks = 0;
+    bool     Ended = false;
+    std::vector<WaveStats> Waves;
+};
+
+struct SessionStats {
+    uint64_t Seed = 0, StartTime = 0;
+    std::vector<RoundStats> Rounds;
+    std::vector<TelemetryRecord> FrameWindows;
+    bool     Ended = false;
+    uint32_t Frames = 0, Dropped = 0, P99Us = 0, MaxUs = 0;
+};
+
+static std::string formatTime(uint64_t unixTime) {
+    time_t t = (time_t)unixTime;
+    char buf[32];
+    if (!strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", localtime(&t))) return "?";
+    return buf;
+}
+
+static double percent(uint64_t part, uint64_t whole) {
+    return whole ? 100.0 * part / whole : 0.0;
+}
+
+static std::vector<SessionStats> collect(const std::vector<TelemetryRecord>& records) {
+    std::vector<SessionStats> sessions;
+    auto round = [&]() -> RoundStats& {
+        // records before any SESSION_START or ROUND_START (a damaged log)
+        // still count, in an unnamed session or round
+        if (sessions.empty()) sessions.emplace_back();
+        SessionStats& s = sessions.back();
+        if (s.Rounds.empty() || s.Rounds.back().Ended) {
+            s.Rounds.emplace_back();
+            s.Rounds.back().Waves.emplace_back();
+        }
+        return s.Rounds.back();
+    };
+    for (const TelemetryRecord& r : records) {
+        switch (r.Type) {
+        case TelemetryType::SESSION_START:
+            sessions.emplace_back();
+            sessions.back().Seed = telemetryU64(r.V[0], r.V[1]);
+            sessions.back().StartTime = telemetryU64(r.V[2], r.V[3]);
+            break;
+        case TelemetryType::ROUND_START:
+            if (sessions.empty()) sessions.emplace_back();
+            sessions.back().Rounds.emplace_back();
+            sessions.back().Rounds.back().Waves.emplace_back();
+            break;
+        case TelemetryType::WAVE: {
+            WaveStats w;
+            w.Number = r.V[0];
+            round().Waves.push_back(w);
+            break;
+        }
+        case TelemetryType::COMBAT: {
+            WaveStats& w = round().Waves.back();
+            w.Shots += r.V[0];
+            w.Hits += r.V[1];
+            w.Misses += r.V[2];
+            break;
+        }
+        case TelemetryType::ROUND_END: {
+            RoundStats& rs = round();
+            rs.Score = r.V[0];
+            rs.Ticks = r.V[3];
+            rs.Ended = true;
+            break;
+        }
+        case TelemetryType::FRAME_TIMES:
+            if (sessions.empty()) sessions.emplace_back();
+            sessions.back().FrameWindows.push_back(r);
+            break;
+        case TelemetryType::SESSION_END:
+            if (sessions.empty()) sessions.emplace_back();
+            sessions.back().Ended = true;
+            sessions.back().Frames = r.V[0];
+            sessions.back().Dropped = r.V[1];
+            sessions.back().P99Us = r.V[2];
+            sessions.back().MaxUs = r.V[3];
+            break;
+        default:
+            break;   // written by a newer build
+        }
+    }
+    return sessions;
+}
+
+static void printSession(size_t index, const SessionStats& s) {
+    printf("\nsession %zu", index + 1);
+    if (s.StartTime) printf("  started %s  seed %llu", formatTime(s.StartTime).c_str(), (unsigned long long)s.Seed);
+    printf("\n");
+
+    uint32_t best = 0;
+    for (size_t i = 0; i < s.Rounds.size(); ++i) {
+        const RoundStats& r = s.Rounds[i];
+        WaveStats total;
+        for (const WaveStats& w : r.Waves) {
+            total.Shots += w.Shots;
+            total.Hits += w.Hits;
+            total.Misses += w.Misses;
+        }
+        best = std::max(best, r.Score);
+        if (r.Ended) printf("  round %zu  score %u  %.1f s", i + 1, r.Score, r.Ticks / TICK_RATE);
+        else printf("  round %zu  unfinished", i + 1);
+        printf("  shots %llu  hits %llu (%.1f%%)  misses %llu\n", (unsigned long long)total.Shots,
+            (unsigned long long)total.Hits, percent(total.Hits, total.Shots), (unsigned long long)total.Misses);
+
+        // per wave only when the round had waves
+        if (r.Waves.size() < 2) continue;
+        for (const WaveStats& w : r.Waves) {
+            if (w.Number == 0 && !w.Shots && !w.Hits && !w.Misses) continue;
+            if (w.Number) printf("    wave %-4u", w.Number);
+            else printf("    (before) ");
+            printf("  shots %6llu  hits %6llu (%5.1f%%)  misses %6llu\n", (unsigned long long)w.Shots,
+                (unsigned long long)w.Hits, percent(w.Hits, w.Shots), (unsigned long long)w.Misses);
+        }
+    }
+    if (!s.Rounds.empty()) printf("  best score %u over %zu rounds\n", best, s.Rounds.size());
+
+    if (!s.FrameWindows.empty()) {
+        // windows are equal in time, not in frames, so the median p50 is
+        // a fair middle and the worst p99 shows the roughest stretch
+        std::vector<uint32_t> p50;
+        uint32_t worstP99 = 0, worstMax = 0;
+        for (const TelemetryRecord& w : s.FrameWindows) {
+            p50.push_back(w.V[0]);
+            worstP99 = std::max(worstP99, w.V[2]);
+            worstMax = std::max(worstMax, w.V[3]);
+        }
+        std::nth_element(p50.begin(), p50.begin() + p50.size() / 2, p50.end());
+        printf("  frame times over %zu windows: median p50 %.2f ms  worst p99 %.2f ms  max %.2f ms\n",
+            s.FrameWindows.size(), p50[p50.size() / 2] / 1000.0, worstP99 / 1000.0, worstMax / 1000.0);
+    }
+    if (s.Ended)
+        printf("  ended cleanly: %u frames, p99 %.2f ms, max %.2f ms, %u records dropped\n",
+            s.Frames, s.P99Us / 1000.0, s.MaxUs / 1000.0, s.Dropped);
+    else printf("  did not end cleanly (crashed or killed)\n");
+}
+
+int main(int argc, char** argv) {
+    const char* path = "telemetry.zvtl";
+    bool all = false;
+    long only = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--all") == 0) all = true;
+        else if (strcmp(argv[i], "--session") == 0 && i + 1 < argc) only = atol(argv[++i]);
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: %s [log] [--all | --session N]\n", argv[0]);
+            return 1;
+        }
+        else path = argv[i];
+    }
+
+    TelemetryScan scan;
+    std::vector<TelemetryRecord> records;
+    std::string error;
+    if (!TelemetryLog::scan(path, scan, error, &records)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    if (!scan.Records) {
+        fprintf(stderr, "%s: no records\n", path);
+        return 1;
+    }
+    std::vector<SessionStats> sessions = collect(records);
+    printf("%s: %llu records, %zu sessions", path, (unsigned long long)scan.Records, sessions.size());
+    if (scan.Corrupt) printf(", %llu damaged records skipped", (unsigned long long)scan.Corrupt);
+    if (scan.TornBytes) printf(", %llu torn bytes at the end", (unsigned long long)scan.TornBytes);
+    printf("\n");
+
+    if (only > 0 && (size_t)only > sessions.size()) {
+        fprintf(stderr, "there is no session %ld\n", only);
+        return 1;
+    }
+    for (size_t i = 0; i < sessions.size(); ++i)
+        if (all || (only > 0 ? i + 1 == (size_t)only : i + 1 == sessions.size())) printSession(i, sessions[i]);
+
+    printf("\nhigh scores\n");
+    for (size_t i = 0; i < scan.HighScores.size(); ++i)
+        printf("  %2zu. %8u  %s\n", i + 1, scan.HighScores[i].Score, formatTime(scan.HighScores[i].UnixTime).c_str());
+    if (scan.HighScores.empty()) printf("  none yet\n");
+    return 0;
+}